@@ -23,16 +23,25 @@
 #define TP_CAMERA_PID   "0107"
 #define USE_DIRECT_SHOW 0
 
-function<void (Mat& image_in, bool dummy_tick)> Camera::callback;
+function<void (bool dummy_tick)> Camera::callback;
 
-unsigned char * myBuffer;
-Mat image_out = Mat(480, 1280, CV_8UC3);
+FrameSource* Camera::frame_source = NULL;
+SessionRecorder* Camera::session_recorder = NULL;
+
+MotionGate Camera::motion_gate;
+
+FramePool Camera::frame_pool(1280, 480);
+FrameMailbox Camera::frame_mailbox(&Camera::frame_pool);
+
+bool Camera::decode_yuv = false;
+
+mutex Camera::device_mutex;
 
 void * pHandle = NULL;
 
 Camera::Camera(){}
 
-Camera::Camera(bool _useMJPEG, int _width, int _height, function<void (Mat& image_in, bool dummy_tick)> callback_in)
+Camera::Camera(bool _useMJPEG, int _width, int _height, function<void (bool dummy_tick)> callback_in)
 {
     height = _height;
     width = _width;
@@ -44,10 +53,37 @@ Camera::Camera(bool _useMJPEG, int _width, int _height, function<void (Mat& imag
 #ifdef __APPLE__
     startVideoStream(_width, _height, 60, MJPEG);
 #endif
+
+    accelerometer_sampler.start([this](int* x, int* y, int* z)
+    {
+        int ret_code = readAccelerometerValues(x, y, z);
+
+        if (session_recorder != NULL)
+            session_recorder->write_accelerometer(*x, *y, *z);
+
+        return ret_code;
+    });
+}
+
+Camera::Camera(FrameSource* _frame_source, function<void (bool dummy_tick)> callback_in)
+{
+    height = 480;
+    width = 1280;
+    callback = callback_in;
+    frame_source = _frame_source;
+    frame_source->start(onMJPEGFrame);
 }
 
 Camera::~Camera()
 {
+    if (frame_source != NULL)
+    {
+        frame_source->stop();
+        return;
+    }
+
+    accelerometer_sampler.stop();
+
 #ifdef _WIN32
     if (ds_camera_)
     {
@@ -70,7 +106,6 @@ uvc_context_t* ctx = NULL;
 uvc_device_handle_t* devh = NULL;
 uvc_device_t* dev;
 unsigned char* liveData;
-uvc_frame_t* bgr;
 
 void Camera::read_ADDR_85(libusb_device_handle* dev_handle, unsigned short wValue)
 {
@@ -126,33 +161,7 @@ int Camera::readFlash(unsigned char* data, int length)
 
 void cb(uvc_frame_t *frame, void *ptr)
 {
-    bool dummy_tick = true;
-    while (waiting_for_image)
-    {
-        uvc_error_t ret = uvc_mjpeg2rgb(frame, bgr);
-        if (ret)
-        {
-            uvc_perror(ret, "change to BGR error");
-            uvc_free_frame(bgr);
-            break;
-        }
-        Mat image_received = Mat(480, 1280, CV_8UC3);
-        image_received.data = (uchar*)bgr->data;
-        
-        const int width = image_received.cols;
-        const int height = image_received.rows;
-        for (int i = 0; i < width; ++i)
-            for (int j = 0; j < height; ++j)
-            {
-                image_out.ptr<uchar>(j, i)[0] = image_received.ptr<uchar>(j, i)[2];
-                image_out.ptr<uchar>(j, i)[1] = image_received.ptr<uchar>(j, i)[1];
-                image_out.ptr<uchar>(j, i)[2] = image_received.ptr<uchar>(j, i)[0];
-            }
-        dummy_tick = false;
-        waiting_for_image = false;
-        break;
-    }
-    Camera::callback(image_out, dummy_tick);
+    Camera::onMJPEGFrame((unsigned char*)frame->data, frame->data_bytes, AccelerometerSampler::get_timestamp());
 }
 
 int Camera::startVideoStream(int width, int height, int framerate, int format)
@@ -190,13 +199,6 @@ int Camera::startVideoStream(int width, int height, int framerate, int format)
     else
     {
         int value = 0;
-        bgr = uvc_allocate_frame(width*height*3);
-        if (!bgr)
-        {
-            printf("unable to allocate bgr frame!");
-            return -1;
-        }
-
         res = uvc_start_streaming(devh, &ctrl, cb, (void*)(&value), 0);
         if (res < 0)
         {
@@ -212,7 +214,6 @@ int Camera::startVideoStream(int width, int height, int framerate, int format)
 int Camera::stopVideoStream()
 {
     uvc_stop_streaming(devh);
-    uvc_free_frame(bgr);
     uvc_close(devh);
     uvc_unref_device(dev);
     uvc_exit(ctx);
@@ -220,25 +221,44 @@ int Camera::stopVideoStream()
 }
 #endif
 
-JPEGDecompressor jpeg_decompressor;
-
-#ifdef _WIN32
-static void frameCallback(BYTE* pBuffer, long lBufferSize)
+void Camera::onMJPEGFrame(unsigned char* data, unsigned long size, long long timestamp)
 {
+    if (session_recorder != NULL)
+        session_recorder->write_frame(data, size);
+
     bool dummy_tick = true;
-    if (waiting_for_image)
-        if (jpeg_decompressor.compute(pBuffer, lBufferSize, myBuffer, 1280, 480))
+
+    //all buffers busy means the tracking thread is behind, drop the frame
+    MJPEGFrame* frame = frame_pool.acquire();
+    if (frame != NULL)
+    {
+        frame->set(data, size);
+        frame->timestamp = timestamp;
+        if (motion_gate.compute(*frame) && (decode_yuv ? frame->decode_planes() : frame->decode_small()))
         {
+            frame_mailbox.post(frame);
             dummy_tick = false;
-            waiting_for_image = false;
         }
-    Camera::callback(image_out, dummy_tick);
+        else
+            frame_pool.release(frame);
+    }
+    callback(dummy_tick);
+}
+
+#ifdef _WIN32
+static void frameCallback(BYTE* pBuffer, long lBufferSize)
+{
+    Camera::onMJPEGFrame(pBuffer, lBufferSize, AccelerometerSampler::get_timestamp());
 }
 #endif
 
 string Camera::getSerialNumber()
 {
+    if (frame_source != NULL)
+        return "";
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
     string result = "";
     unsigned char serialNumber[10];
@@ -476,8 +496,6 @@ int Camera::doSetup(const int & format)
         return 0;
     
     const int fmt = 1;
-    myBuffer = (unsigned char *)malloc(1280 * 480 * 3);
-    image_out.data = myBuffer;
     bool retV = ds_camera_->OpenCamera(touchCameraId, format, 1280, 480, 60, frameCallback);
 
     console_log("camera opened = " + to_string(retV));
@@ -520,7 +538,11 @@ int Camera::doSetup(const int & format)
 
 int Camera::setExposureTime(int whichSide, float expTime)
 {
+    if (frame_source != NULL)
+        return 1;
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
 #ifdef _WIN32
     int retCode= eSPAEAWB_SetExposureTime(whichSide, expTime);
@@ -831,7 +853,11 @@ int Camera::setExposureTime(int whichSide, float expTime)
 
 float Camera::getExposureTime(int whichSide)
 {
+    if (frame_source != NULL)
+        return -1;
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
 #ifdef _WIN32
     float eTime = -1.0;
@@ -967,7 +993,11 @@ float Camera::getExposureTime(int whichSide)
 
 int Camera::setGlobalGain(int whichSide, float gain)
 {
+    if (frame_source != NULL)
+        return 1;
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
 #ifdef _WIN32
     return eSPAEAWB_SetGlobalGain(whichSide, gain);
@@ -994,7 +1024,11 @@ int Camera::setGlobalGain(int whichSide, float gain)
 
 float Camera::getGlobalGain(int whichSide)
 {
+    if (frame_source != NULL)
+        return -1;
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
 #ifdef _WIN32
     float globalGain = -1.0;
@@ -1021,7 +1055,11 @@ float Camera::getGlobalGain(int whichSide)
 
 int Camera::turnLEDsOn()
 {
+    if (frame_source != NULL)
+        return 1;
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
 #ifdef _WIN32
     BYTE gpio_code;
@@ -1060,7 +1098,11 @@ int Camera::turnLEDsOn()
 
 int Camera::turnLEDsOff()
 {
+    if (frame_source != NULL)
+        return 1;
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
 #ifdef _WIN32
     BYTE gpio_code;
@@ -1097,6 +1139,54 @@ int Camera::turnLEDsOff()
 
 int Camera::getAccelerometerValues(int *x, int *y, int *z)
 {
+    if (frame_source != NULL)
+    {
+        //the first recorded reading, so that a replay starts from the same heading every time
+        AccelerometerSample samples[ACCELEROMETER_SAMPLE_HISTORY];
+        const int sample_count = frame_source->get_accelerometer_samples(0, samples);
+
+        *x = sample_count > 0 ? samples[sample_count - 1].x : 0;
+        *y = sample_count > 0 ? samples[sample_count - 1].y : 0;
+        *z = sample_count > 0 ? samples[sample_count - 1].z : 0;
+        return sample_count > 0;
+    }
+
+    AccelerometerSample sample_previous;
+    AccelerometerSample sample_latest;
+    if (accelerometer_sampler.get(sample_previous, sample_latest))
+    {
+        *x = sample_latest.x;
+        *y = sample_latest.y;
+        *z = sample_latest.z;
+        return 1;
+    }
+
+    int ret_code = readAccelerometerValues(x, y, z);
+
+    if (session_recorder != NULL)
+        session_recorder->write_accelerometer(*x, *y, *z);
+
+    return ret_code;
+}
+
+int Camera::getAccelerometerSamples(const long long timestamp, AccelerometerSample* samples_out)
+{
+    const int sample_count = frame_source != NULL ? frame_source->get_accelerometer_samples(timestamp, samples_out) :
+                                                    accelerometer_sampler.get_samples(samples_out);
+    if (sample_count > 0)
+        return sample_count;
+
+    //sessions without readings and a sampler without readings yet fall back to a single reading
+    getAccelerometerValues(&samples_out[0].x, &samples_out[0].y, &samples_out[0].z);
+    samples_out[0].timestamp = 0;
+
+    return 1;
+}
+
+int Camera::readAccelerometerValues(int *x, int *y, int *z)
+{
+    lock_guard<mutex> lock(device_mutex);
+
 #ifdef _WIN32
     return eSPAEAWB_GetAccMeterValue(x, y, z);
 
@@ -1177,7 +1267,11 @@ int Camera::getAccelerometerValues(int *x, int *y, int *z)
 
 int	Camera::setColorGains(int whichSide, float red, float green, float blue)
 {
+    if (frame_source != NULL)
+        return 1;
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
 #ifdef _WIN32
     return eSPAEAWB_SetColorGain(whichSide, red, green, blue);
@@ -1287,7 +1381,11 @@ int	Camera::setColorGains(int whichSide, float red, float green, float blue)
 
 int	Camera::getColorGains(int whichSide, float *red, float *green, float * blue)
 {
+    if (frame_source != NULL)
+        return 1;
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
 #ifdef _WIN32
     return eSPAEAWB_GetColorGain(whichSide, red, green, blue);
@@ -1338,7 +1436,11 @@ int	Camera::getColorGains(int whichSide, float *red, float *green, float * blue)
 
 int Camera::enableAutoExposure(int whichSide)
 {
+    if (frame_source != NULL)
+        return 1;
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
 #ifdef _WIN32
     eSPAEAWB_SelectDevice(whichSide);
@@ -1446,7 +1548,11 @@ int Camera::enableAutoExposure(int whichSide)
 
 int Camera::disableAutoExposure(int whichSide)
 {
+    if (frame_source != NULL)
+        return 1;
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
 #ifdef _WIN32
     eSPAEAWB_SelectDevice(whichSide);
@@ -1552,7 +1658,11 @@ int Camera::disableAutoExposure(int whichSide)
 
 int Camera::enableAutoWhiteBalance(int whichSide)
 {
+    if (frame_source != NULL)
+        return 1;
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
 #ifdef _WIN32
     eSPAEAWB_SelectDevice(whichSide);
@@ -1658,7 +1768,11 @@ int Camera::enableAutoWhiteBalance(int whichSide)
 
 int Camera::disableAutoWhiteBalance(int whichSide)
 {
+    if (frame_source != NULL)
+        return 1;
+
     Sleep(10);
+    lock_guard<mutex> lock(device_mutex);
 
 #ifdef _WIN32
     eSPAEAWB_SelectDevice(whichSide);
@@ -31,6 +31,7 @@
 
 #include <stdio.h>
 #include <functional>
+#include <mutex>
 #include "opencv2/opencv.hpp"
 #include <time.h>
 #include <fstream>
@@ -39,7 +40,12 @@
 #include <algorithm>
 
 #include "globals.h"
-#include "jpeg_decompressor.h"
+#include "mjpeg_frame.h"
+#include "frame_mailbox.h"
+#include "frame_source.h"
+#include "session_recorder.h"
+#include "motion_gate.h"
+#include "accelerometer_sampler.h"
 
 using namespace cv;
 using namespace std;
@@ -51,7 +57,8 @@ class Camera
     
 public:
 	Camera();
-	Camera(bool _useMJPEG, int _width, int _height, function<void (Mat& image_in, bool dummy_tick)> callback_in);
+	Camera(bool _useMJPEG, int _width, int _height, function<void (bool dummy_tick)> callback_in);
+	Camera(FrameSource* _frame_source, function<void (bool dummy_tick)> callback_in);
 	~Camera();
 
 	unsigned char* frame;
@@ -62,10 +69,36 @@ public:
 	unsigned static const right = 1;
 	unsigned static const both = 2;
 
-	static function<void (Mat& image_in, bool dummy_tick)> callback;
+	static function<void (bool dummy_tick)> callback;
+
+	//replaces the hardware when set, camera controls become no-ops
+	static FrameSource* frame_source;
+	static SessionRecorder* session_recorder;
+
+	static MotionGate motion_gate;
+
+	//decoded frames are handed to the tracking thread through the mailbox, the pool bounds the buffers in flight
+	static FramePool frame_pool;
+	static FrameMailbox frame_mailbox;
+
+	//decode frames to Y, Cb and Cr planes instead of BGR, off by default since the converted gray and the Canny
+	//thresholds tuned on it differ slightly from the BGR path
+	static bool decode_yuv;
+
+	//timestamp is the capture time, same clock as the accelerometer readings of the frame's source
+	static void onMJPEGFrame(unsigned char* data, unsigned long size, long long timestamp);
 	
-	//accelerometer acquisition
+	//held for every whole register transaction, the accelerometer sampler thread shares the device with the camera controls
+	static mutex device_mutex;
+
+	//accelerometer acquisition, once the sampler is running the getters only read its cached readings
+	AccelerometerSampler accelerometer_sampler;
+
 	int getAccelerometerValues(int *x, int *y, int *z);
+	//fills up to ACCELEROMETER_SAMPLE_HISTORY readings oldest first and returns how many, a replayed session gives the
+	//recorded readings around timestamp, a live camera its latest ones
+	int getAccelerometerSamples(const long long timestamp, AccelerometerSample* samples_out);
+	int readAccelerometerValues(int *x, int *y, int *z);
 	
 	// Camera Parameters
 	int		setExposureTime(int whichSide, float expTime);
@@ -0,0 +1,112 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "accelerometer_sampler.h"
+
+AccelerometerSampler::AccelerometerSampler()
+{
+	sequence = 0;
+	stop_requested = false;
+}
+
+AccelerometerSampler::~AccelerometerSampler()
+{
+	stop();
+}
+
+void AccelerometerSampler::start(function<int (int* x, int* y, int* z)> _read_function, const int _interval_ms)
+{
+	if (sampler_thread != NULL)
+		return;
+
+	read_function = _read_function;
+	interval_ms = _interval_ms;
+	stop_requested = false;
+	sampler_thread = new thread(&AccelerometerSampler::run, this);
+}
+
+void AccelerometerSampler::stop()
+{
+	if (sampler_thread == NULL)
+		return;
+
+	stop_requested = true;
+	sampler_thread->join();
+	delete sampler_thread;
+	sampler_thread = NULL;
+}
+
+void AccelerometerSampler::run()
+{
+	while (!stop_requested)
+	{
+		const chrono::steady_clock::time_point time_next = chrono::steady_clock::now() + chrono::milliseconds(interval_ms);
+
+		AccelerometerSample sample;
+		read_function(&sample.x, &sample.y, &sample.z);
+		sample.timestamp = get_timestamp();
+
+		const unsigned int sequence_next = sequence.load(memory_order_relaxed) + 1;
+		sample_slots[sequence_next % ACCELEROMETER_SAMPLE_SLOTS] = sample;
+		sequence.store(sequence_next, memory_order_release);
+
+		this_thread::sleep_until(time_next);
+	}
+}
+
+bool AccelerometerSampler::get(AccelerometerSample& sample_previous, AccelerometerSample& sample_latest)
+{
+	while (true)
+	{
+		const unsigned int sequence_latest = sequence.load(memory_order_acquire);
+		if (sequence_latest == 0)
+			return false;
+
+		sample_latest = sample_slots[sequence_latest % ACCELEROMETER_SAMPLE_SLOTS];
+		sample_previous = sequence_latest > 1 ? sample_slots[(sequence_latest - 1) % ACCELEROMETER_SAMPLE_SLOTS] : sample_latest;
+
+		//two more publishes would let the writer start on the slot of sample_previous, retry when the copies may be torn
+		atomic_thread_fence(memory_order_acquire);
+		if (sequence.load(memory_order_relaxed) - sequence_latest < 2)
+			return true;
+	}
+}
+
+int AccelerometerSampler::get_samples(AccelerometerSample* samples_out)
+{
+	while (true)
+	{
+		const unsigned int sequence_latest = sequence.load(memory_order_acquire);
+		if (sequence_latest == 0)
+			return 0;
+
+		const int sample_count = min(sequence_latest, (unsigned int)ACCELEROMETER_SAMPLE_HISTORY);
+		for (int i = 0; i < sample_count; ++i)
+			samples_out[i] = sample_slots[(sequence_latest - sample_count + 1 + i) % ACCELEROMETER_SAMPLE_SLOTS];
+
+		//same as in get, two more publishes would let the writer start on the slot of the oldest copy
+		atomic_thread_fence(memory_order_acquire);
+		if (sequence.load(memory_order_relaxed) - sequence_latest < 2)
+			return sample_count;
+	}
+}
+
+long long AccelerometerSampler::get_timestamp()
+{
+	return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
\ No newline at end of file
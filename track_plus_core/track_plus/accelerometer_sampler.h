@@ -0,0 +1,70 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+
+using namespace std;
+
+#define ACCELEROMETER_SAMPLE_INTERVAL_MS 10
+#define ACCELEROMETER_SAMPLE_SLOTS 8
+//readings get_samples can hand out, the writer may be filling the slot after the latest and publish one more meanwhile
+#define ACCELEROMETER_SAMPLE_HISTORY (ACCELEROMETER_SAMPLE_SLOTS - 2)
+
+struct AccelerometerSample
+{
+	//microseconds, same clock as MJPEGFrame::timestamp
+	long long timestamp = 0;
+	int x = 0;
+	int y = 0;
+	int z = 0;
+};
+
+//polls the accelerometer on its own thread, readers never touch the device
+class AccelerometerSampler
+{
+public:
+	//written by the sampler thread only, a slot is reused ACCELEROMETER_SAMPLE_SLOTS publishes later
+	AccelerometerSample sample_slots[ACCELEROMETER_SAMPLE_SLOTS];
+	//count of published samples, the latest one sits in sample_slots[sequence % ACCELEROMETER_SAMPLE_SLOTS]
+	atomic<unsigned int> sequence;
+
+	atomic<bool> stop_requested;
+	thread* sampler_thread = NULL;
+
+	function<int (int* x, int* y, int* z)> read_function;
+	int interval_ms;
+
+	AccelerometerSampler();
+	~AccelerometerSampler();
+
+	void start(function<int (int* x, int* y, int* z)> _read_function, const int _interval_ms = ACCELEROMETER_SAMPLE_INTERVAL_MS);
+	void stop();
+	void run();
+	//previous and latest readings, returns false until the first reading is published
+	bool get(AccelerometerSample& sample_previous, AccelerometerSample& sample_latest);
+	//up to ACCELEROMETER_SAMPLE_HISTORY of the latest readings oldest first, returns how many, 0 before the first one
+	int get_samples(AccelerometerSample* samples_out);
+
+	static long long get_timestamp();
+};
\ No newline at end of file
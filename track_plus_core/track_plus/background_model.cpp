@@ -0,0 +1,118 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "background_model.h"
+
+bool BackgroundModel::compute(Mat& image_in)
+{
+	int rate = 65536 / (frame_count + 1);
+	if (rate > 32767)
+		rate = 32767;
+	else if (rate < rate_min)
+		rate = rate_min;
+
+	const int locked_count_old = locked_count;
+
+	locked_count = 0;
+	deviating_count = 0;
+
+	for (int j = 0; j < HEIGHT_SMALL; ++j)
+		simd_kernels.background_model_row(image_in.ptr<uchar>(j), image_skip.ptr<uchar>(j), image_mean.ptr<ushort>(j),
+										  image_variance.ptr<ushort>(j), image_count.ptr<ushort>(j), WIDTH_SMALL,
+										  rate, lock_in, locked_count, deviating_count);
+
+	++frame_count;
+
+	if (locked_count_old > 0 && deviating_count > locked_count * lighting_change_ratio)
+	{
+		reset();
+		return false;
+	}
+	return true;
+}
+
+void BackgroundModel::classify(Mat& image_in, Mat& image_out)
+{
+	image_out.create(HEIGHT_SMALL, WIDTH_SMALL, CV_8UC1);
+
+	for (int j = 0; j < HEIGHT_SMALL; ++j)
+	{
+		const uchar* row_in = image_in.ptr<uchar>(j);
+		const ushort* row_mean = image_mean.ptr<ushort>(j);
+		const ushort* row_variance = image_variance.ptr<ushort>(j);
+		const ushort* row_count = image_count.ptr<ushort>(j);
+		uchar* row_out = image_out.ptr<uchar>(j);
+
+		for (int i = 0; i < WIDTH_SMALL; ++i)
+		{
+			if (row_count[i] < lock_in)
+			{
+				row_out[i] = 255;
+				continue;
+			}
+
+			int dev = abs((row_in[i] << 7) - row_mean[i]) >> 7;
+			if (dev > BACKGROUND_MODEL_DEV_MAX)
+				dev = BACKGROUND_MODEL_DEV_MAX;
+
+			const int dev_sq = (dev * dev) << 4;
+			int variance_k = row_variance[i] * 6;
+			if (variance_k > 65535)
+				variance_k = 65535;
+
+			row_out[i] = dev > BACKGROUND_MODEL_DIFF_MIN && dev_sq > variance_k ? 254 : 0;
+		}
+	}
+}
+
+void BackgroundModel::exclude(Mat& image_foreground)
+{
+	image_foreground.copyTo(image_skip);
+	exclude_set = true;
+}
+
+int BackgroundModel::fill_unknown(Mat& image_background)
+{
+	int fill_count = 0;
+	if (!exclude_set)
+		return fill_count;
+
+	for (int j = 0; j < HEIGHT_SMALL; ++j)
+	{
+		uchar* row_background = image_background.ptr<uchar>(j);
+		ushort* row_mean = image_mean.ptr<ushort>(j);
+		ushort* row_count = image_count.ptr<ushort>(j);
+		uchar* row_skip = image_skip.ptr<uchar>(j);
+
+		for (int i = 0; i < WIDTH_SMALL; ++i)
+			if (row_background[i] == 255 && row_count[i] >= lock_in && row_skip[i] == 0)
+			{
+				//254 at most, 255 marks an unknown pixel
+				const int gray = (row_mean[i] + 64) >> 7;
+				row_background[i] = gray > 254 ? 254 : gray;
+				++fill_count;
+			}
+	}
+	return fill_count;
+}
+
+void BackgroundModel::reset()
+{
+	frame_count = 0;
+	image_count.setTo(0);
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include "globals.h"
+#include "simd_functions.h"
+
+class BackgroundModel
+{
+public:
+	//a pixel is trusted once it has seen lock_in consistent samples, the learning rate starts at 1/2 and decays as 1/n
+	//toward rate_min so that the mean settles within a few frames after start up or a lighting change
+	int lock_in = 8;
+	int rate_min = 2048;
+
+	//more than this share of locked pixels deviating in one frame is taken as a lighting change and restarts the model
+	float lighting_change_ratio = 0.5;
+
+	int frame_count = 0;
+	int locked_count = 0;
+	int deviating_count = 0;
+
+	//nothing is filled before a foreground mask came in, a hand held still from the start would lock in otherwise
+	bool exclude_set = false;
+
+	//planar so that each row of each plane is contiguous for the row kernel
+	Mat image_mean = Mat::zeros(HEIGHT_SMALL, WIDTH_SMALL, CV_16UC1);
+	Mat image_variance = Mat::zeros(HEIGHT_SMALL, WIDTH_SMALL, CV_16UC1);
+	Mat image_count = Mat::zeros(HEIGHT_SMALL, WIDTH_SMALL, CV_16UC1);
+	Mat image_skip = Mat::zeros(HEIGHT_SMALL, WIDTH_SMALL, CV_8UC1);
+
+	//returns false when the frame was taken as a lighting change
+	bool compute(Mat& image_in);
+	//254 where a locked pixel is off its mean by more than its variance allows, 0 where it is not and 255 where the pixel
+	//has not locked in yet, with the same test the update uses to tell a deviating sample from noise
+	void classify(Mat& image_in, Mat& image_out);
+	//nonzero pixels are kept out of the next updates, the mask holds until the next call and survives a reset
+	void exclude(Mat& image_foreground);
+	int fill_unknown(Mat& image_background);
+	void reset();
+};
\ No newline at end of file
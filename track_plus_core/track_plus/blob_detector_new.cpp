@@ -17,369 +17,246 @@
  */
 
 #include "blob_detector_new.h"
+#include "console_log.h"
 
-void BlobDetectorNew::compute(Mat& image_in, uchar gray_in, int x_min_in, int x_max_in, int y_min_in, int y_max_in, bool shallow, bool octal)
+static inline int find_run_root(vector<BlobRun>& runs, int k)
 {
-	x_min_result = 9999;
-	x_max_result = 0;
-	y_min_result = 9999;
-	y_max_result = 0;
+	while (runs[k].parent != k)
+	{
+		runs[k].parent = runs[runs[k].parent].parent;
+		k = runs[k].parent;
+	}
+	return k;
+}
 
-	image_atlas = Mat::zeros(image_in.rows, image_in.cols, CV_16UC1);
-	Mat image_clone = image_in;
+static inline void union_runs(vector<BlobRun>& runs, const int k0, const int k1)
+{
+	const int root0 = find_run_root(runs, k0);
+	const int root1 = find_run_root(runs, k1);
 
-	delete blobs;
-	blobs = new vector<BlobNew>();
-	blob_max_size_actual = BlobNew();
-	blob_max_size = &blob_max_size_actual;
+	if (root0 < root1)
+		runs[root1].parent = root0;
+	else if (root1 < root0)
+		runs[root0].parent = root1;
+}
 
-	const int j_min = y_min_in < 1 ? 1 : y_min_in;
-	const int j_max = y_max_in > image_in.rows - 2 ? image_in.rows - 2 : y_max_in;
+//same blobs as flooding from every seed in the region with the 1 pixel border of the image left unexpanded: components
+//are labeled on the inner pixels, blobs are created in the order their first seed comes up in the scan, and a border pixel
+//goes to the first created blob next to it
+template <bool octal>
+void BlobDetectorNew::label(Mat& image_in, const uchar gray_in, const int i_min, const int i_max, const int j_min, const int j_max)
+{
+	const int width = image_in.cols;
+	const int height = image_in.rows;
+	const int reach = octal ? 1 : 0;
 
-	const int i_min = x_min_in < 1 ? 1 : x_min_in;
-	const int i_max = x_max_in > image_in.cols - 2 ? image_in.cols - 2 : x_max_in;
+	runs.clear();
+	row_run_index.assign(height + 1, 0);
 
-	const int y_min = 0;
-	const int y_max = image_in.rows - 1;
+	int row_begin_above = 0;
+	int row_end_above = 0;
 
-	const int x_min = 0;
-	const int x_max = image_in.cols - 1;
+	for (int j = 1; j < height - 1; ++j)
+	{
+		const uchar* row = image_in.ptr<uchar>(j);
+		const int row_begin = runs.size();
+		row_run_index[j] = row_begin;
 
-	for (int j = j_min; j < j_max; ++j)
-		for (int i = i_min; i < i_max; ++i)
+		int i = 1;
+		while (i < width - 1)
 		{
-			uchar* pix_ptr = &image_clone.ptr<uchar>(j, i)[0];
-
-			if (*pix_ptr != gray_in)
+			if (row[i] != gray_in)
+			{
+				++i;
 				continue;
+			}
 
-			blobs->push_back(BlobNew(image_atlas, blobs->size() + 1));
-			BlobNew* blob = &((*blobs)[blobs->size() - 1]);
-			blob->add(i, j);
-			*pix_ptr = 255;
+			BlobRun run;
+			run.i_begin = i;
+			while (i < width - 1 && row[i] == gray_in)
+				++i;
 
-			for (int k = 0; k < blob->data.size(); ++k)
-			{
-				const int pt_x = blob->data[k].x;
-				const int pt_y = blob->data[k].y;
+			run.i_end = i - 1;
+			run.j = j;
+			run.parent = runs.size();
+			runs.push_back(run);
+		}
 
-				if (pt_x <= x_min || pt_x >= x_max || pt_y <= y_min || pt_y >= y_max)
-					continue;
+		const int row_end = runs.size();
 
-				const int pt_x0 = pt_x - 1;
-				const int pt_y0 = pt_y - 1;
-				const int pt_x1 = pt_x + 1;
-				const int pt_y1 = pt_y + 1;
+		//runs of both rows are sorted by i
+		int k_above = row_begin_above;
+		for (int k = row_begin; k < row_end; ++k)
+		{
+			const int i_begin = runs[k].i_begin - reach;
+			const int i_end = runs[k].i_end + reach;
 
-				pix_ptr = &image_clone.ptr<uchar>(pt_y, pt_x0)[0];
-				if (*pix_ptr == gray_in)
-				{
-					blob->add(pt_x0, pt_y);
-					*pix_ptr = 255;
-				}
-				pix_ptr = &image_clone.ptr<uchar>(pt_y, pt_x1)[0];
-				if (*pix_ptr == gray_in)
-				{
-					blob->add(pt_x1, pt_y);
-					*pix_ptr = 255;
-				}
-				pix_ptr = &image_clone.ptr<uchar>(pt_y0, pt_x)[0];
-				if (*pix_ptr == gray_in)
-				{
-					blob->add(pt_x, pt_y0);
-					*pix_ptr = 255;
-				}
-				pix_ptr = &image_clone.ptr<uchar>(pt_y1, pt_x)[0];
-				if (*pix_ptr == gray_in)
-				{
-					blob->add(pt_x, pt_y1);
-					*pix_ptr = 255;
-				}
+			while (k_above < row_end_above && runs[k_above].i_end < i_begin)
+				++k_above;
 
-				if (octal)
-				{
-					pix_ptr = &image_clone.ptr<uchar>(pt_y0, pt_x0)[0];
-					if (*pix_ptr == gray_in)
-					{
-						blob->add(pt_x0, pt_y0);
-						*pix_ptr = 255;
-					}
-					pix_ptr = &image_clone.ptr<uchar>(pt_y1, pt_x1)[0];
-					if (*pix_ptr == gray_in)
-					{
-						blob->add(pt_x1, pt_y1);
-						*pix_ptr = 255;
-					}
-					pix_ptr = &image_clone.ptr<uchar>(pt_y0, pt_x1)[0];
-					if (*pix_ptr == gray_in)
-					{
-						blob->add(pt_x1, pt_y0);
-						*pix_ptr = 255;
-					}
-					pix_ptr = &image_clone.ptr<uchar>(pt_y1, pt_x0)[0];
-					if (*pix_ptr == gray_in)
-					{
-						blob->add(pt_x0, pt_y1);
-						*pix_ptr = 255;
-					}
-				}
-			}
+			for (int k_overlap = k_above; k_overlap < row_end_above && runs[k_overlap].i_begin <= i_end; ++k_overlap)
+				union_runs(runs, k, k_overlap);
+		}
 
-			blob->compute();
+		row_begin_above = row_begin;
+		row_end_above = row_end;
+	}
 
-			if (blob->data.size() > blob_max_size->data.size())
-			{
-				blob_max_size_actual = *blob;
-				blob_max_size = &blob_max_size_actual;
-			}
+	if (height > 1)
+		row_run_index[height - 1] = runs.size();
 
-			if (blob->x_min < x_min_result)
-				x_min_result = blob->x_min;
-			if (blob->x_max > x_max_result)
-				x_max_result = blob->x_max;
-			if (blob->y_min < y_min_result)
-				y_min_result = blob->y_min;
-			if (blob->y_max > y_max_result)
-			{
-				y_max_result = blob->y_max;
-				pt_y_max_result = blob->pt_y_max;
-			}
-		}
+	//------------------------------------------------------------------------------------------------------------------------
 
-	if (!shallow)
-		for (BlobNew& blob : *blobs)
-			blob.fill(image_clone, gray_in);
-}
+	const int run_count = runs.size();
+	root_blob_index.assign(run_count, -1);
 
-void BlobDetectorNew::compute_region(Mat& image_in, uchar gray_in, vector<Point>& region_vec, bool shallow, bool octal)
-{
-	x_min_result = 9999;
-	x_max_result = 0;
-	y_min_result = 9999;
-	y_max_result = 0;
+	for (int k = 0; k < run_count; ++k)
+	{
+		const BlobRun& run = runs[k];
+		if (run.j < j_min || run.j >= j_max || max(run.i_begin, i_min) > min(run.i_end, i_max - 1))
+			continue;
 
-	image_atlas = Mat::zeros(image_in.rows, image_in.cols, CV_16UC1);
-	Mat image_clone = image_in;
+		const int root = find_run_root(runs, k);
+		if (root_blob_index[root] != -1)
+			continue;
 
-	delete blobs;
-	blobs = new vector<BlobNew>();
-	blob_max_size_actual = BlobNew();
-	blob_max_size = &blob_max_size_actual;
+		root_blob_index[root] = blobs->size();
+		blobs->push_back(BlobNew(image_atlas, blobs->size() + 1, &arena));
+	}
 
-	for (Point& pt_region : region_vec)
+	if (blobs->size() == 0)
+		return;
+
+	for (int k = 0; k < run_count; ++k)
 	{
-		int i = pt_region.x;
-		int j = pt_region.y;
-		
-		uchar* pix_ptr = &image_clone.ptr<uchar>(j, i)[0];
+		runs[k].parent = find_run_root(runs, k);
 
-		if (*pix_ptr != gray_in)
+		const int blob_index = root_blob_index[runs[k].parent];
+		if (blob_index == -1)
 			continue;
 
-		blobs->push_back(BlobNew(image_atlas, blobs->size() + 1));
-		BlobNew* blob = &((*blobs)[blobs->size() - 1]);
-		blob->add(i, j);
-		*pix_ptr = 255;
+		const BlobRun& run = runs[k];
+		ushort* row_atlas = image_atlas.ptr<ushort>(run.j);
+		std::fill(row_atlas + run.i_begin, row_atlas + run.i_end + 1, blob_index + 1);
+	}
 
-		for (int k = 0; k < blob->data.size(); ++k)
-		{
-			const int pt_x = blob->data[k].x;
-			const int pt_y = blob->data[k].y;
+	//------------------------------------------------------------------------------------------------------------------------
 
-			const int pt_x0 = pt_x - 1;
-			const int pt_y0 = pt_y - 1;
-			const int pt_x1 = pt_x + 1;
-			const int pt_y1 = pt_y + 1;
+	for (int j = 0; j < height; ++j)
+	{
+		const uchar* row = image_in.ptr<uchar>(j);
+		ushort* row_atlas = image_atlas.ptr<ushort>(j);
 
-			pix_ptr = &image_clone.ptr<uchar>(pt_y, pt_x0)[0];
-			if (*pix_ptr == gray_in)
-			{
-				blob->add(pt_x0, pt_y);
-				*pix_ptr = 255;
-			}
-			pix_ptr = &image_clone.ptr<uchar>(pt_y, pt_x1)[0];
-			if (*pix_ptr == gray_in)
-			{
-				blob->add(pt_x1, pt_y);
-				*pix_ptr = 255;
-			}
-			pix_ptr = &image_clone.ptr<uchar>(pt_y0, pt_x)[0];
-			if (*pix_ptr == gray_in)
-			{
-				blob->add(pt_x, pt_y0);
-				*pix_ptr = 255;
-			}
-			pix_ptr = &image_clone.ptr<uchar>(pt_y1, pt_x)[0];
-			if (*pix_ptr == gray_in)
-			{
-				blob->add(pt_x, pt_y1);
-				*pix_ptr = 255;
-			}
+		const bool border_row = j == 0 || j == height - 1;
+		const int i_step = border_row ? 1 : width - 1;
 
-			if (octal)
-			{
-				pix_ptr = &image_clone.ptr<uchar>(pt_y0, pt_x0)[0];
-				if (*pix_ptr == gray_in)
-				{
-					blob->add(pt_x0, pt_y0);
-					*pix_ptr = 255;
-				}
-				pix_ptr = &image_clone.ptr<uchar>(pt_y1, pt_x1)[0];
-				if (*pix_ptr == gray_in)
-				{
-					blob->add(pt_x1, pt_y1);
-					*pix_ptr = 255;
-				}
-				pix_ptr = &image_clone.ptr<uchar>(pt_y0, pt_x1)[0];
-				if (*pix_ptr == gray_in)
-				{
-					blob->add(pt_x1, pt_y0);
-					*pix_ptr = 255;
-				}
-				pix_ptr = &image_clone.ptr<uchar>(pt_y1, pt_x0)[0];
-				if (*pix_ptr == gray_in)
+		for (int i = 0; i < width; i += i_step)
+		{
+			if (row[i] != gray_in)
+				continue;
+
+			ushort atlas_id = 0;
+			for (int y = j - 1; y <= j + 1; ++y)
+				for (int x = i - 1; x <= i + 1; ++x)
 				{
-					blob->add(pt_x0, pt_y1);
-					*pix_ptr = 255;
+					if (y < 1 || y > height - 2 || x < 1 || x > width - 2)
+						continue;
+					if (!octal && x != i && y != j)
+						continue;
+
+					const ushort atlas_id_neighbor = image_atlas.ptr<ushort>(y)[x];
+					if (atlas_id_neighbor > 0 && (atlas_id == 0 || atlas_id_neighbor < atlas_id))
+						atlas_id = atlas_id_neighbor;
 				}
-			}
+
+			if (atlas_id > 0)
+				row_atlas[i] = atlas_id;
 		}
+	}
+
+	//------------------------------------------------------------------------------------------------------------------------
 
-		blob->compute();
+	//runs already come in raster order, the border pixels of a row go before and after them
+	for (int j = 0; j < height; ++j)
+	{
+		const ushort* row_atlas = image_atlas.ptr<ushort>(j);
 
-		if (blob->data.size() > blob_max_size->data.size())
+		if (j == 0 || j == height - 1)
 		{
-			blob_max_size_actual = *blob;
-			blob_max_size = &blob_max_size_actual;
+			for (int i = 0; i < width; ++i)
+				if (row_atlas[i] > 0)
+					(*blobs)[row_atlas[i] - 1].add_run(i, i, j);
+
+			continue;
 		}
 
-		if (blob->x_min < x_min_result)
-			x_min_result = blob->x_min;
-		if (blob->x_max > x_max_result)
-			x_max_result = blob->x_max;
-		if (blob->y_min < y_min_result)
-			y_min_result = blob->y_min;
-		if (blob->y_max > y_max_result)
+		if (row_atlas[0] > 0)
+			(*blobs)[row_atlas[0] - 1].add_run(0, 0, j);
+
+		for (int k = row_run_index[j]; k < row_run_index[j + 1]; ++k)
 		{
-			y_max_result = blob->y_max;
-			pt_y_max_result = blob->pt_y_max;
+			const int blob_index = root_blob_index[runs[k].parent];
+			if (blob_index != -1)
+				(*blobs)[blob_index].add_run(runs[k].i_begin, runs[k].i_end, j);
 		}
-	}
 
-	if (!shallow)
-		for (BlobNew& blob : *blobs)
-			blob.fill(image_clone, gray_in);
+		if (width > 1 && row_atlas[width - 1] > 0)
+			(*blobs)[row_atlas[width - 1] - 1].add_run(width - 1, width - 1, j);
+	}
 }
 
-void BlobDetectorNew::compute_location(Mat& image_in, const uchar gray_in, const int i, const int j,
-									   bool shallow, bool in_process, bool octal)
+static inline void flood_visit(uchar* pix_ptr, const uchar gray_in, BlobNew* blob, const int x, const int y)
 {
-	if (in_process == false)
+	if (*pix_ptr == gray_in)
 	{
-		x_min_result = 9999;
-		x_max_result = 0;
-		y_min_result = 9999;
-		y_max_result = 0;
-
-		image_atlas = Mat::zeros(image_in.rows, image_in.cols, CV_16UC1);
-		
-		delete blobs;
-		blobs = new vector<BlobNew>();
-		blob_max_size_actual = BlobNew();
-		blob_max_size = &blob_max_size_actual;
+		blob->add(x, y);
+		*pix_ptr = 255;
 	}
+}
 
-	Mat image_clone = image_in;
-
-	const int j_max = image_in.rows - 2;
-	const int i_max = image_in.cols - 2;
-	const int y_max = image_in.rows - 1;
+//breadth first from data[0], callers that walk skeletons and contour segments rely on data ending at the far end
+template <bool octal, bool check_bounds>
+void BlobDetectorNew::flood(Mat& image_in, const uchar gray_in, BlobNew* blob)
+{
 	const int x_max = image_in.cols - 1;
+	const int y_max = image_in.rows - 1;
+	const int step = image_in.step;
 
-	uchar* pix_ptr = &image_clone.ptr<uchar>(j, i)[0];
-
-	if (*pix_ptr != gray_in)
-		return;
-
-	blobs->push_back(BlobNew(image_atlas, blobs->size() + 1));
-	BlobNew* blob = &((*blobs)[blobs->size() - 1]);
-	blob->add(i, j);
-	*pix_ptr = 255;
-
-	for (int k = 0; k < blob->data.size(); ++k)
+	for (int k = 0; k < (int)blob->data.size(); ++k)
 	{
 		const int pt_x = blob->data[k].x;
 		const int pt_y = blob->data[k].y;
 
-		if (pt_x <= 0 || pt_x >= x_max || pt_y <= 0 || pt_y >= y_max)
+		if (check_bounds && (pt_x <= 0 || pt_x >= x_max || pt_y <= 0 || pt_y >= y_max))
 			continue;
 
-		const int pt_x0 = pt_x - 1;
-		const int pt_y0 = pt_y - 1;
-		const int pt_x1 = pt_x + 1;
-		const int pt_y1 = pt_y + 1;
+		uchar* pix_ptr = image_in.ptr<uchar>(pt_y) + pt_x;
 
-		pix_ptr = &image_clone.ptr<uchar>(pt_y, pt_x0)[0];
-		if (*pix_ptr == gray_in)
-		{
-			blob->add(pt_x0, pt_y);
-			*pix_ptr = 255;
-		}
-		pix_ptr = &image_clone.ptr<uchar>(pt_y, pt_x1)[0];
-		if (*pix_ptr == gray_in)
-		{
-			blob->add(pt_x1, pt_y);
-			*pix_ptr = 255;
-		}
-		pix_ptr = &image_clone.ptr<uchar>(pt_y0, pt_x)[0];
-		if (*pix_ptr == gray_in)
-		{
-			blob->add(pt_x, pt_y0);
-			*pix_ptr = 255;
-		}
-		pix_ptr = &image_clone.ptr<uchar>(pt_y1, pt_x)[0];
-		if (*pix_ptr == gray_in)
-		{
-			blob->add(pt_x, pt_y1);
-			*pix_ptr = 255;
-		}
+		flood_visit(pix_ptr - 1, gray_in, blob, pt_x - 1, pt_y);
+		flood_visit(pix_ptr + 1, gray_in, blob, pt_x + 1, pt_y);
+		flood_visit(pix_ptr - step, gray_in, blob, pt_x, pt_y - 1);
+		flood_visit(pix_ptr + step, gray_in, blob, pt_x, pt_y + 1);
 
 		if (octal)
 		{
-			pix_ptr = &image_clone.ptr<uchar>(pt_y0, pt_x0)[0];
-			if (*pix_ptr == gray_in)
-			{
-				blob->add(pt_x0, pt_y0);
-				*pix_ptr = 255;
-			}
-			pix_ptr = &image_clone.ptr<uchar>(pt_y1, pt_x1)[0];
-			if (*pix_ptr == gray_in)
-			{
-				blob->add(pt_x1, pt_y1);
-				*pix_ptr = 255;
-			}
-			pix_ptr = &image_clone.ptr<uchar>(pt_y0, pt_x1)[0];
-			if (*pix_ptr == gray_in)
-			{
-				blob->add(pt_x1, pt_y0);
-				*pix_ptr = 255;
-			}
-			pix_ptr = &image_clone.ptr<uchar>(pt_y1, pt_x0)[0];
-			if (*pix_ptr == gray_in)
-			{
-				blob->add(pt_x0, pt_y1);
-				*pix_ptr = 255;
-			}
+			flood_visit(pix_ptr - step - 1, gray_in, blob, pt_x - 1, pt_y - 1);
+			flood_visit(pix_ptr + step + 1, gray_in, blob, pt_x + 1, pt_y + 1);
+			flood_visit(pix_ptr - step + 1, gray_in, blob, pt_x + 1, pt_y - 1);
+			flood_visit(pix_ptr + step - 1, gray_in, blob, pt_x - 1, pt_y + 1);
 		}
 	}
+}
 
+void BlobDetectorNew::add_blob_result(const int blob_index)
+{
+	BlobNew* blob = &(*blobs)[blob_index];
 	blob->compute();
 
-	if (blob->data.size() > blob_max_size->data.size())
-	{
-		blob_max_size_actual = *blob;
-		blob_max_size = &blob_max_size_actual;
-	}
+	if (blob_max_size_index == -1 || blob->count > (*blobs)[blob_max_size_index].count)
+		blob_max_size_index = blob_index;
+
+	//blobs may have grown since the last call
+	blob_max_size = &(*blobs)[blob_max_size_index];
 
 	if (blob->x_min < x_min_result)
 		x_min_result = blob->x_min;
@@ -392,26 +269,171 @@ void BlobDetectorNew::compute_location(Mat& image_in, const uchar gray_in, const
 		y_max_result = blob->y_max;
 		pt_y_max_result = blob->pt_y_max;
 	}
+}
+
+//results of the previous call are dropped here, the blob vector, atlas and arena are kept and rewound
+void BlobDetectorNew::begin_compute(Mat& image_in)
+{
+	x_min_result = 9999;
+	x_max_result = 0;
+	y_min_result = 9999;
+	y_max_result = 0;
+
+	arena_allocation_count_begin = arena.heap_allocation_count;
+	get_capacities(capacity_begin);
+	growth_count = 0;
+
+	const uchar* atlas_data_old = image_atlas.data;
+	image_atlas.create(image_in.rows, image_in.cols, CV_16UC1);
+	image_atlas = Scalar(0);
+	if (image_atlas.data != atlas_data_old)
+		++growth_count;
+
+	//the blobs give their storage back to the arena before it is rewound
+	blobs->clear();
+	blob_max_size = &blob_none;
+	blob_max_size_index = -1;
+	arena.reset();
+}
+
+void BlobDetectorNew::end_compute()
+{
+	size_t capacity_end[4];
+	get_capacities(capacity_end);
+
+	growth_count += arena.heap_allocation_count - arena_allocation_count_begin;
+	arena_allocation_count_begin = arena.heap_allocation_count;
+
+	for (int a = 0; a < 4; ++a)
+		if (capacity_end[a] != capacity_begin[a])
+		{
+			++growth_count;
+			capacity_begin[a] = capacity_end[a];
+		}
+
+	//growth only settles once the scene has been seen, afterwards it means the arena or scratch is not reused
+	++compute_count;
+	if (compute_count > BLOB_DETECTOR_WARM_UP_COMPUTES && growth_count > 0)
+	{
+		++growth_compute_count;
+		if (compute_count_logged == 0 || compute_count - compute_count_logged >= BLOB_DETECTOR_LOG_INTERVAL)
+		{
+			console_log("blob detector grew after warm up in " + to_string(growth_compute_count) + " of " +
+						to_string(compute_count - BLOB_DETECTOR_WARM_UP_COMPUTES) + " computes");
+			compute_count_logged = compute_count;
+		}
+	}
+}
+
+void BlobDetectorNew::get_capacities(size_t* capacities)
+{
+	capacities[0] = blobs->capacity();
+	capacities[1] = runs.capacity();
+	capacities[2] = row_run_index.capacity();
+	capacities[3] = root_blob_index.capacity();
+}
+
+void BlobDetectorNew::compute(Mat& image_in, uchar gray_in, int x_min_in, int x_max_in, int y_min_in, int y_max_in, bool shallow, bool octal)
+{
+	begin_compute(image_in);
+
+	const int j_min = y_min_in < 1 ? 1 : y_min_in;
+	const int j_max = y_max_in > image_in.rows - 2 ? image_in.rows - 2 : y_max_in;
+
+	const int i_min = x_min_in < 1 ? 1 : x_min_in;
+	const int i_max = x_max_in > image_in.cols - 2 ? image_in.cols - 2 : x_max_in;
+
+	if (octal)
+		label<true>(image_in, gray_in, i_min, i_max, j_min, j_max);
+	else
+		label<false>(image_in, gray_in, i_min, i_max, j_min, j_max);
+
+	const int blob_count = blobs->size();
+	for (int blob_index = 0; blob_index < blob_count; ++blob_index)
+		add_blob_result(blob_index);
+
+	//labeled pixels are left at 255 like the flood fill leaves its visited pixels
+	if (shallow)
+		for (BlobNew& blob : *blobs)
+			blob.fill(image_in, 255);
+
+	end_compute();
+}
+
+void BlobDetectorNew::compute_region(Mat& image_in, uchar gray_in, vector<Point>& region_vec, bool shallow, bool octal)
+{
+	begin_compute(image_in);
+	Mat image_clone = image_in;
+
+	for (Point& pt_region : region_vec)
+	{
+		int i = pt_region.x;
+		int j = pt_region.y;
+		
+		uchar* pix_ptr = &image_clone.ptr<uchar>(j, i)[0];
+
+		if (*pix_ptr != gray_in)
+			continue;
+
+		blobs->push_back(BlobNew(image_atlas, blobs->size() + 1, &arena));
+		BlobNew* blob = &((*blobs)[blobs->size() - 1]);
+		blob->add(i, j);
+		*pix_ptr = 255;
+
+		if (octal)
+			flood<true, false>(image_clone, gray_in, blob);
+		else
+			flood<false, false>(image_clone, gray_in, blob);
+
+		add_blob_result(blobs->size() - 1);
+	}
+
+	if (!shallow)
+		for (BlobNew& blob : *blobs)
+			blob.fill(image_clone, gray_in);
+
+	end_compute();
+}
+
+void BlobDetectorNew::compute_location(Mat& image_in, const uchar gray_in, const int i, const int j,
+									   bool shallow, bool in_process, bool octal)
+{
+	if (in_process == false)
+		begin_compute(image_in);
+
+	Mat image_clone = image_in;
+
+	uchar* pix_ptr = &image_clone.ptr<uchar>(j, i)[0];
+
+	if (*pix_ptr != gray_in)
+	{
+		end_compute();
+		return;
+	}
+
+	blobs->push_back(BlobNew(image_atlas, blobs->size() + 1, &arena));
+	BlobNew* blob = &((*blobs)[blobs->size() - 1]);
+	blob->add(i, j);
+	*pix_ptr = 255;
+
+	if (octal)
+		flood<true, true>(image_clone, gray_in, blob);
+	else
+		flood<false, true>(image_clone, gray_in, blob);
+
+	add_blob_result(blobs->size() - 1);
 
 	if (!shallow)
 		for (BlobNew& blob : *blobs)
 			blob.fill(image_clone, gray_in);
+
+	end_compute();
 }
 
 void BlobDetectorNew::compute_all(Mat& image_in, bool octal)
 {
-	x_min_result = 9999;
-	x_max_result = 0;
-	y_min_result = 9999;
-	y_max_result = 0;
+	begin_compute(image_in);
 
-	image_atlas = Mat::zeros(image_in.rows, image_in.cols, CV_16UC1);
-	
-	delete blobs;
-	blobs = new vector<BlobNew>();
-	blob_max_size_actual = BlobNew();
-	blob_max_size = &blob_max_size_actual;
-	
 	const int width_const = image_in.cols;
 	const int height_const = image_in.rows;
 
@@ -473,29 +495,73 @@ struct compare_blob_x_min
 	}
 };
 
+//indices are sorted and every blob is then moved once along the cycles of the permutation
+template <typename Compare>
+void BlobDetectorNew::sort_blobs(Compare compare)
+{
+	vector<BlobNew>& blob_vec = *blobs;
+	const int blob_count = blob_vec.size();
+
+	blob_order.resize(blob_count);
+	for (int a = 0; a < blob_count; ++a)
+		blob_order[a] = a;
+
+	sort(blob_order.begin(), blob_order.end(), [&](const int index0, const int index1)
+	{
+		return compare(blob_vec[index0], blob_vec[index1]);
+	});
+
+	for (int a = 0; a < blob_count; ++a)
+		if (blob_order[a] == blob_max_size_index)
+		{
+			blob_max_size_index = a;
+			blob_max_size = &blob_vec[a];
+			break;
+		}
+
+	//blob_order[a] is where the blob going to a comes from, visited slots are marked with -1
+	for (int a = 0; a < blob_count; ++a)
+	{
+		if (blob_order[a] == -1 || blob_order[a] == a)
+			continue;
+
+		BlobNew blob_temp = move(blob_vec[a]);
+		int index_dst = a;
+		while (blob_order[index_dst] != a)
+		{
+			const int index_src = blob_order[index_dst];
+			blob_vec[index_dst] = move(blob_vec[index_src]);
+			blob_order[index_dst] = -1;
+			index_dst = index_src;
+		}
+		blob_vec[index_dst] = move(blob_temp);
+		blob_order[index_dst] = -1;
+	}
+}
+
 void BlobDetectorNew::sort_blobs_by_count()
 {
-	sort(blobs->begin(), blobs->end(), compare_blob_count());
+	sort_blobs(compare_blob_count());
 }
 
 void BlobDetectorNew::sort_blobs_by_angle(Point& pivot)
 {
-	sort(blobs->begin(), blobs->end(), compare_blob_angle(pivot));
+	sort_blobs(compare_blob_angle(pivot));
 }
 
 void BlobDetectorNew::sort_blobs_by_x()
 {
-	sort(blobs->begin(), blobs->end(), compare_blob_x());
+	sort_blobs(compare_blob_x());
 }
 
 void BlobDetectorNew::sort_blobs_by_y_max()
 {
-	sort(blobs->begin(), blobs->end(), compare_blob_y_max());
+	sort_blobs(compare_blob_y_max());
 }
 
 void BlobDetectorNew::sort_blobs_by_x_min()
 {
-	sort(blobs->begin(), blobs->end(), compare_blob_x_min());
+	sort_blobs(compare_blob_x_min());
 }
 
 void BlobDetectorNew::reconstruct_atlas_image(Mat& _image_atlas, vector<BlobNew>& _blob_vec)
@@ -503,8 +569,11 @@ void BlobDetectorNew::reconstruct_atlas_image(Mat& _image_atlas, vector<BlobNew>
 	_image_atlas = Mat::zeros(HEIGHT_SMALL, WIDTH_SMALL, CV_16UC1);
 	for (BlobNew& blob : _blob_vec)
 	{
-		for (Point& pt : blob.data)
-			_image_atlas.ptr<ushort>(pt.y, pt.x)[0] = blob.atlas_id;
+		for (BlobSpan& span : blob.spans)
+		{
+			ushort* row_atlas = _image_atlas.ptr<ushort>(span.j);
+			std::fill(row_atlas + span.i_begin, row_atlas + span.i_end + 1, blob.atlas_id);
+		}
 
 		blob.image_atlas = _image_atlas;
 	}
@@ -22,13 +22,30 @@
 #include "globals.h"
 #include "math_plus.h"
 
+#define BLOB_DETECTOR_WARM_UP_COMPUTES 100
+#define BLOB_DETECTOR_LOG_INTERVAL     1000
+
+//horizontal run of one row, parent links the runs of one component
+struct BlobRun
+{
+	int i_begin;
+	int i_end;
+	int j;
+	int parent;
+};
+
 class BlobDetectorNew
 {
 public:
 	vector<BlobNew>* blobs = new vector<BlobNew>();
-	BlobNew blob_max_size_actual;
-	BlobNew* blob_max_size = &blob_max_size_actual;
+	//spans and data of the current blobs, rewound at the start of every compute
+	FrameArena arena;
+	//points into blobs, or at the empty blob_none when there are none, the index survives blobs growing and sorting
+	BlobNew blob_none;
+	BlobNew* blob_max_size = &blob_none;
+	int blob_max_size_index = -1;
 
+	//cleared and reused by every compute, blobs still point at it, the copies in a HandSplitterResult do not
 	Mat image_atlas;
 
 	int x_min_result;
@@ -38,6 +55,25 @@ public:
 
 	Point pt_y_max_result;
 
+	//scratch of the two pass labeling in compute, kept so that it only grows once
+	vector<BlobRun> runs;
+	vector<int> row_run_index;
+	vector<int> root_blob_index;
+	vector<int> blob_order;
+
+	//growth seen by the last compute, 0 for a steady state frame: new arena blocks, a new atlas and each of blobs and the
+	//scratch vectors whose capacity changed count once each however many mallocs they took. nothing inside the blobs is
+	//seen, and BlobNew is not nothrow movable with the OpenCV 2.4 Mat, so when blobs grows every blob is copied and its
+	//spans and data go to the heap until the next compute
+	int growth_count = 0;
+	int arena_allocation_count_begin = 0;
+	size_t capacity_begin[4];
+
+	//computes after warm up that still grew, logged at most once per BLOB_DETECTOR_LOG_INTERVAL computes
+	int compute_count = 0;
+	int growth_compute_count = 0;
+	int compute_count_logged = 0;
+
 	void compute(Mat& image_in, uchar gray_in, int x_min_in, int x_max_in, int y_min_in, int y_max_in, bool shallow, bool octal = 0);
 	void compute_region(Mat& image_in, uchar gray_in, vector<Point>& region_vec, bool shallow, bool octal);
 	void compute_location(Mat& image_in, const uchar gray_in, const int i, const int j, bool shallow, bool in_process = 0, bool octal = 0);
@@ -50,4 +86,12 @@ public:
 
 	static void reconstruct_atlas_image(Mat& _image_atlas, vector<BlobNew>& _blob_vec);
 	static void reconstruct_atlas_image_rotated(Mat& _image_atlas, vector<BlobNew>& _blob_vec);
+
+	template <bool octal> void label(Mat& image_in, const uchar gray_in, const int i_min, const int i_max, const int j_min, const int j_max);
+	template <bool octal, bool check_bounds> void flood(Mat& image_in, const uchar gray_in, BlobNew* blob);
+	template <typename Compare> void sort_blobs(Compare compare);
+	void add_blob_result(const int blob_index);
+	void begin_compute(Mat& image_in);
+	void end_compute();
+	void get_capacities(size_t* capacities);
 };
\ No newline at end of file
@@ -20,7 +20,10 @@
 
 BlobNew::BlobNew(){}
 
-BlobNew::BlobNew(Mat& image_atlas_in, const ushort atlas_id_in)
+BlobNew::BlobNew(FrameArena* arena_in) : spans(ArenaAllocator<BlobSpan>(arena_in)), data(ArenaAllocator<Point>(arena_in)){}
+
+BlobNew::BlobNew(Mat& image_atlas_in, const ushort atlas_id_in, FrameArena* arena_in)
+	: spans(ArenaAllocator<BlobSpan>(arena_in)), data(ArenaAllocator<Point>(arena_in))
 {
 	image_atlas = image_atlas_in;
 	atlas_id = atlas_id_in;
@@ -30,6 +33,17 @@ void BlobNew::add(const int i_in, const int j_in)
 {
 	data.push_back(Point(i_in, j_in));
 
+	if (!spans.empty() && spans.back().j == j_in && spans.back().i_end + 1 == i_in)
+		++spans.back().i_end;
+	else
+	{
+		BlobSpan span;
+		span.i_begin = i_in;
+		span.i_end = i_in;
+		span.j = j_in;
+		spans.push_back(span);
+	}
+
 	if (i_in < x_min)
 	{
 		x_min = i_in;
@@ -51,9 +65,50 @@ void BlobNew::add(const int i_in, const int j_in)
 		pt_y_max = Point(i_in, j_in);
 	}
 
+	x_sum += i_in;
+	y_sum += j_in;
+
 	image_atlas.ptr<ushort>(j_in, i_in)[0] = atlas_id;
 }
 
+void BlobNew::add_run(const int i_begin, const int i_end, const int j)
+{
+	BlobSpan span;
+	span.i_begin = i_begin;
+	span.i_end = i_end;
+	span.j = j;
+	spans.push_back(span);
+
+	//same extreme points add would pick for these pixels in this order
+	if (i_begin < x_min)
+	{
+		x_min = i_begin;
+		pt_x_min = Point(i_begin, j);
+	}
+	if (i_end > x_max)
+	{
+		x_max = i_end;
+		pt_x_max = Point(i_end, j);
+	}
+	if (j < y_min)
+	{
+		y_min = j;
+		pt_y_min = Point(i_begin, j);
+	}
+	if (j > y_max)
+	{
+		y_max = j;
+		pt_y_max = Point(i_begin, j);
+	}
+
+	const int run_count = i_end - i_begin + 1;
+	x_sum += (i_begin + i_end) * run_count / 2;
+	y_sum += j * run_count;
+
+	ushort* row_atlas = image_atlas.ptr<ushort>(j);
+	std::fill(row_atlas + i_begin, row_atlas + i_end + 1, atlas_id);
+}
+
 void BlobNew::compute()
 {
 	width = x_max - x_min;
@@ -61,15 +116,39 @@ void BlobNew::compute()
 	area = width * height;
 	x = (x_max - x_min) / 2 + x_min;
 	y = (y_max - y_min) / 2 + y_min;
-	count = data.size();
+
+	count = 0;
+	for (BlobSpan& span : spans)
+		count += span.i_end - span.i_begin + 1;
+
+	if (count > 0)
+		pt_centroid = Point2f((float)x_sum / count, (float)y_sum / count);
+}
+
+vector<Point, ArenaAllocator<Point>>& BlobNew::get_data()
+{
+	if (data.size() == (size_t)count)
+		return data;
+
+	data.clear();
+	data.reserve(count);
+	for (BlobSpan& span : spans)
+		for (int i = span.i_begin; i <= span.i_end; ++i)
+			data.push_back(Point(i, span.j));
+
+	return data;
 }
 
 int BlobNew::compute_overlap(BlobNew& blob_in)
 {
 	int overlap_count = 0;
-	for (Point& pt : blob_in.data)
-		if (image_atlas.ptr<ushort>(pt.y, pt.x)[0] == atlas_id)
-			++overlap_count;
+	for (BlobSpan& span : blob_in.spans)
+	{
+		const ushort* row_atlas = image_atlas.ptr<ushort>(span.j);
+		for (int i = span.i_begin; i <= span.i_end; ++i)
+			if (row_atlas[i] == atlas_id)
+				++overlap_count;
+	}
 
 	return overlap_count;
 }
@@ -83,38 +162,45 @@ int BlobNew::compute_overlap(BlobNew& blob_in, const int x_diff_in, const int y_
 		return 0;
 
 	Mat image_blob_in = Mat::zeros(j_max, i_max, CV_8UC1);
-	for (Point& pt : blob_in.data)
+	for (BlobSpan& span : blob_in.spans)
 	{
-		int i = pt.x + x_diff_in;
-		int j = pt.y + y_diff_in;
+		const int j = span.j + y_diff_in;
+		const int i_begin = max(span.i_begin + x_diff_in, 0);
+		const int i_end = min(span.i_end + x_diff_in, i_max - 1);
 
-		if (i < 0 || i >= i_max || j < 0 || j >= j_max)
+		if (j < 0 || j >= j_max || i_begin > i_end)
 			continue;
 
-		image_blob_in.ptr<uchar>(j, i)[0] = 254;
+		memset(image_blob_in.ptr<uchar>(j) + i_begin, 254, i_end - i_begin + 1);
 	}
 
 	dilate(image_blob_in, image_blob_in, Mat(), Point(-1, -1), dilate_num);
 
 	int overlap_count = 0;
-	for (Point& pt : data)
+	for (BlobSpan& span : spans)
 	{
-		if (pt.x >= i_max || pt.y >= j_max)
+		if (span.j >= j_max)
 			continue;
-		
-		if (image_blob_in.ptr<uchar>(pt.y, pt.x)[0] > 0)
-			++overlap_count;
+
+		const uchar* row = image_blob_in.ptr<uchar>(span.j);
+		const int i_end = min(span.i_end, i_max - 1);
+		for (int i = span.i_begin; i <= i_end; ++i)
+			if (row[i] > 0)
+				++overlap_count;
 	}
 
 	return overlap_count;
 }
 
+//the pixel of a span closest to pt_in is the one nearest in x, spans go in the order pixels were added so the first of
+//equally close pixels wins like it did over data
 float BlobNew::compute_min_dist(Point pt_in, Point* pt_out, bool accurate)
 {
 	float dist_min = 9999;
 	Point pt_dist_min;
-	for (Point& pt : data)
+	for (BlobSpan& span : spans)
 	{
+		const Point pt = Point(min(max(pt_in.x, span.i_begin), span.i_end), span.j);
 		const float dist_current = get_distance(pt_in, pt, accurate);
 		if (dist_current < dist_min)
 		{
@@ -130,33 +216,71 @@ float BlobNew::compute_min_dist(Point pt_in, Point* pt_out, bool accurate)
 
 Point BlobNew::compute_median_point()
 {
-	vector<int> x_vec;
-	vector<int> y_vec;
-	for (Point& pt : data)
+	if (spans.empty())
+		return Point(0, 0);
+
+	//pixel counts per column and per row stand in for the sorted coordinates
+	vector<int> x_count_vec(x_max - x_min + 2, 0);
+	vector<int> y_count_vec(y_max - y_min + 1, 0);
+	int size = 0;
+	for (BlobSpan& span : spans)
 	{
-		x_vec.push_back(pt.x);
-		y_vec.push_back(pt.y);
+		++x_count_vec[span.i_begin - x_min];
+		--x_count_vec[span.i_end + 1 - x_min];
+		y_count_vec[span.j - y_min] += span.i_end - span.i_begin + 1;
+		size += span.i_end - span.i_begin + 1;
 	}
-	sort(x_vec.begin(), x_vec.end());
-	sort(y_vec.begin(), y_vec.end());
-	
-	return Point(x_vec[x_vec.size() / 2], y_vec[y_vec.size() / 2]);
+
+	const int index_median = size / 2;
+
+	int x_median = x_min;
+	int x_count = 0;
+	int x_cumulative = 0;
+	for (int i = 0; i < (int)x_count_vec.size() - 1; ++i)
+	{
+		x_count += x_count_vec[i];
+		x_cumulative += x_count;
+		if (x_cumulative > index_median)
+		{
+			x_median = x_min + i;
+			break;
+		}
+	}
+
+	int y_median = y_min;
+	int y_cumulative = 0;
+	for (int j = 0; j < (int)y_count_vec.size(); ++j)
+	{
+		y_cumulative += y_count_vec[j];
+		if (y_cumulative > index_median)
+		{
+			y_median = y_min + j;
+			break;
+		}
+	}
+
+	return Point(x_median, y_median);
 }
 
 void BlobNew::fill(Mat& image_in, const uchar gray_in, bool check_bounds)
 {
 	if (!check_bounds)
 	{
-		for (Point pt : data)
-			image_in.ptr<uchar>(pt.y, pt.x)[0] = gray_in;
+		for (BlobSpan& span : spans)
+			memset(image_in.ptr<uchar>(span.j) + span.i_begin, gray_in, span.i_end - span.i_begin + 1);
 	}
 	else
 	{
 		const int image_width = image_in.cols;
 		const int image_height = image_in.rows;
 
-		for (Point pt : data)
-			if (pt.x >= 0 && pt.y >= 0 && pt.x < image_width && pt.y < image_height)
-				image_in.ptr<uchar>(pt.y, pt.x)[0] = gray_in;
+		for (BlobSpan& span : spans)
+		{
+			const int i_begin = max(span.i_begin, 0);
+			const int i_end = min(span.i_end, image_width - 1);
+
+			if (span.j >= 0 && span.j < image_height && i_begin <= i_end)
+				memset(image_in.ptr<uchar>(span.j) + i_begin, gray_in, i_end - i_begin + 1);
+		}
 	}
 }
\ No newline at end of file
@@ -21,18 +21,31 @@
 #include <opencv2/opencv.hpp>
 #include "globals.h"
 #include "math_plus.h"
+#include "frame_arena.h"
 
 using namespace std;
 using namespace cv;
 
+//pixels i_begin .. i_end of row j
+struct BlobSpan
+{
+	int i_begin;
+	int i_end;
+	int j;
+};
+
 class BlobNew
 {
 public:
+	//labels of the detector that found the blob, rewritten by its next compute, copies handed to other threads drop it
 	Mat image_atlas;
 
 	ushort atlas_id;
 
-	vector<Point> data;
+	//spans always cover the blob, data holds the pixels added one by one and is otherwise built from spans by get_data,
+	//both come from the arena of the detector when there is one
+	vector<BlobSpan, ArenaAllocator<BlobSpan>> spans;
+	vector<Point, ArenaAllocator<Point>> data;
 	vector<Point> skeleton;
 	vector<Point> data_rotated;
 	vector<Point> skeleton_rotated;
@@ -61,6 +74,12 @@ public:
 
 	float dist = -1;
 
+	//sums of data for the centroid, kept up by add and add_run
+	int x_sum = 0;
+	int y_sum = 0;
+
+	Point2f pt_centroid;
+
 	Point pt_y_min = Point(0, 9999);
 	Point pt_y_max = Point(0, 0);
 	Point pt_x_min = Point(9999, 0);
@@ -77,10 +96,15 @@ public:
 	BlobNew* matching_blob = NULL;
 
 	BlobNew();
-	BlobNew(Mat& image_atlas_in, const ushort atlas_id_in);
+	BlobNew(FrameArena* arena_in);
+	BlobNew(Mat& image_atlas_in, const ushort atlas_id_in, FrameArena* arena_in = NULL);
 
 	void add(const int i, const int j);
+	//pixels i_begin .. i_end of row j, in order
+	void add_run(const int i_begin, const int i_end, const int j);
 	void compute();
+	//every pixel in the order it was added, valid after compute
+	vector<Point, ArenaAllocator<Point>>& get_data();
 	int compute_overlap(BlobNew& blob_in);
 	int compute_overlap(BlobNew& blob_in, const int x_diff_in, const int y_diff_in, const int dilate_num);
 	float compute_min_dist(Point pt_in, Point* pt_out, bool accurate);
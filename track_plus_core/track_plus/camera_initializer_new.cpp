@@ -66,7 +66,7 @@ bool CameraInitializerNew::adjust_exposure(Camera* camera, Mat& image_in, bool r
 	{
 		if (count == 5)
 		{
-			image_leds_on = image_in;
+			image_in.copyTo(image_leds_on);
 			GaussianBlur(image_leds_on, image_leds_on, Size(49, 49), 0, 0);
 			camera->turnLEDsOff();
 		}
@@ -80,7 +80,7 @@ bool CameraInitializerNew::adjust_exposure(Camera* camera, Mat& image_in, bool r
 	}
 	else if (step1 == false)
 	{
-		image_leds_off = image_in;
+		image_in.copyTo(image_leds_off);
 		GaussianBlur(image_leds_off, image_leds_off, Size(49, 49), 0, 0);
 		camera->turnLEDsOn();
 		step1 = true;
@@ -18,33 +18,6 @@
 
 #include "contour_functions.h"
 
-vector<vector<Point>> legacyFindContours(Mat& Segmented)
-{
-	IplImage        SegmentedIpl = Segmented;
-	CvMemStorage*   storage = cvCreateMemStorage(0);
-	CvSeq*          contours = 0;
-
-	cvFindContours(&SegmentedIpl, storage, &contours, sizeof(CvContour), CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE, cvPoint(0, 0));
-
-	vector<vector<Point>> result;
-	for (; contours != 0; contours = contours->h_next)
-	{
-		vector<Point> contour_current;
-		for (int i = 0; i < contours->total; ++i)
-		{
-			CvPoint* point = (CvPoint*)CV_GET_SEQ_ELEM(CvPoint, contours, i);
-			Point pt = Point(point->x, point->y);
-			contour_current.push_back(pt);
-		}
-
-		if (contour_current.size() > 0)
-			result.push_back(contour_current);
-	}
-
-	cvReleaseMemStorage(&storage);
-	return result;
-}
-
 void approximate_contour(vector<Point>& points, vector<Point>& points_approximated, int theta_threshold, int skip_count)
 {
 	if (points.size() == 0)
@@ -26,8 +26,6 @@
 using namespace std;
 using namespace cv;
 
-vector<vector<Point>> legacyFindContours(Mat& Segmented);
-
 void approximate_contour(vector<Point>& points, vector<Point>& points_approximated, int theta_threshold, int skip_count);
 
 void midpoint_circle(int x_in, int y_in, int radius_in, vector<Point>& result_out);
@@ -0,0 +1,243 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "contour_tracer.h"
+
+//chain code directions, 0 is right and they go counterclockwise on screen
+static const int dx_chain[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int dy_chain[8] = { 0, -1, -1, -1, 0, 1, 1, 1 };
+
+struct MaskForeground
+{
+	const Mat& image;
+	const int width;
+	const int height;
+
+	MaskForeground(const Mat& image_in) : image(image_in), width(image_in.cols), height(image_in.rows) { }
+
+	inline bool operator()(const int x, const int y) const
+	{
+		return x > 0 && y > 0 && x < width - 1 && y < height - 1 && image.ptr<uchar>(y)[x] != 0;
+	}
+};
+
+struct AtlasForeground
+{
+	const Mat& image_atlas;
+	const uchar* atlas_id_active;
+	const int atlas_id_count;
+	const int width;
+	const int height;
+
+	AtlasForeground(const Mat& image_atlas_in, const vector<uchar>& atlas_id_active_in) :
+		image_atlas(image_atlas_in), atlas_id_active(atlas_id_active_in.data()), atlas_id_count(atlas_id_active_in.size()),
+		width(image_atlas_in.cols), height(image_atlas_in.rows) { }
+
+	inline bool operator()(const int x, const int y) const
+	{
+		if (x <= 0 || y <= 0 || x >= width - 1 || y >= height - 1)
+			return false;
+
+		const ushort atlas_id = image_atlas.ptr<ushort>(y)[x];
+		return atlas_id < atlas_id_count && atlas_id_active[atlas_id] != 0;
+	}
+};
+
+void ContourTracer::compute(Mat& image_in, vector<vector<Point>>& contours_out)
+{
+	width = image_in.cols;
+	height = image_in.rows;
+	contour_count = 0;
+	marks.assign(width * height, 0);
+
+	MaskForeground foreground(image_in);
+
+	//a border starts where an unmarked foreground pixel follows background, it is external unless the last marked pixel
+	//passed in the row is on the left side of a traced border
+	for (int j = 1; j < height - 1; ++j)
+	{
+		const schar* row_marks = &marks[j * width];
+		const uchar* row = image_in.ptr<uchar>(j);
+
+		int value_prev = 0;
+		int value_marked = 0;
+		for (int i = 1; i < width - 1; ++i)
+		{
+			int value = row_marks[i] != 0 ? row_marks[i] : row[i] != 0;
+			if (value == value_prev)
+				continue;
+
+			if (value_prev == 0 && value == 1 && value_marked <= 0)
+			{
+				trace(foreground, i, j, contours_out);
+				value = row_marks[i];
+			}
+
+			value_prev = value;
+			if (value & -2)
+				value_marked = value;
+		}
+	}
+
+	end_compute(contours_out);
+}
+
+void ContourTracer::compute(BlobDetectorNew& blob_detector, vector<vector<Point>>& contours_out)
+{
+	Mat& image_atlas = blob_detector.image_atlas;
+
+	width = image_atlas.cols;
+	height = image_atlas.rows;
+	contour_count = 0;
+
+	ushort atlas_id_max = 0;
+	for (BlobNew& blob : *blob_detector.blobs)
+		if (blob.atlas_id > atlas_id_max)
+			atlas_id_max = blob.atlas_id;
+
+	atlas_id_active.assign(atlas_id_max + 1, 0);
+	seeds.clear();
+
+	//every span begin inside the image frame is where a row of the mask goes from background to foreground
+	for (BlobNew& blob : *blob_detector.blobs)
+	{
+		if (!blob.active)
+			continue;
+
+		atlas_id_active[blob.atlas_id] = 1;
+
+		for (BlobSpan& span : blob.spans)
+			if (span.j > 0 && span.j < height - 1 && span.i_begin < width - 1 && span.i_end > 0)
+				seeds.push_back(Point(max(span.i_begin, 1), span.j));
+	}
+
+	if (seeds.size() == 0)
+	{
+		end_compute(contours_out);
+		return;
+	}
+
+	marks.assign(width * height, 0);
+
+	sort(seeds.begin(), seeds.end(), [](const Point& a, const Point& b)
+	{
+		return a.y < b.y || (a.y == b.y && a.x < b.x);
+	});
+
+	AtlasForeground foreground(image_atlas, atlas_id_active);
+
+	//in raster order the marks left of a seed are final, so the last one decides what the row scan would have
+	for (Point& seed : seeds)
+	{
+		const schar* row_marks = &marks[seed.y * width];
+		if (row_marks[seed.x] != 0)
+			continue;
+
+		int value_marked = 0;
+		for (int i = seed.x - 1; i > 0; --i)
+			if (row_marks[i] != 0)
+			{
+				value_marked = row_marks[i];
+				break;
+			}
+
+		if (value_marked <= 0)
+			trace(foreground, seed.x, seed.y, contours_out);
+	}
+
+	end_compute(contours_out);
+}
+
+template <typename Foreground> void ContourTracer::trace(Foreground& foreground, const int x_start, const int y_start,
+														 vector<vector<Point>>& contours_out)
+{
+	if (contour_count == (int)contours_out.size())
+		contours_out.push_back(vector<Point>());
+
+	vector<Point>& contour = contours_out[contour_count];
+	contour.clear();
+	++contour_count;
+
+	//the last pixel of the border is the first foreground neighbor clockwise from the upper left
+	int s = 4;
+	do
+	{
+		s = (s - 1) & 7;
+		if (foreground(x_start + dx_chain[s], y_start + dy_chain[s]))
+			break;
+	}
+	while (s != 4);
+
+	if (s == 4)
+	{
+		marks[y_start * width + x_start] = -126;
+		contour.push_back(Point(x_start, y_start));
+		return;
+	}
+
+	const int x_last = x_start + dx_chain[s];
+	const int y_last = y_start + dy_chain[s];
+
+	int x = x_start;
+	int y = y_start;
+	int s_prev = s ^ 4;
+
+	//counterclockwise around each pixel from where the border came in, a point goes in wherever the direction turns
+	while (true)
+	{
+		const int s_end = s;
+
+		int x_next;
+		int y_next;
+		while (true)
+		{
+			++s;
+			x_next = x + dx_chain[s & 7];
+			y_next = y + dy_chain[s & 7];
+			if (foreground(x_next, y_next))
+				break;
+		}
+		s &= 7;
+
+		schar& mark = marks[y * width + x];
+		if ((unsigned)(s - 1) < (unsigned)s_end)
+			mark = -126;
+		else if (mark == 0)
+			mark = 2;
+
+		if (s != s_prev)
+		{
+			contour.push_back(Point(x, y));
+			s_prev = s;
+		}
+
+		if (x_next == x_start && y_next == y_start && x == x_last && y == y_last)
+			break;
+
+		x = x_next;
+		y = y_next;
+		s = (s + 4) & 7;
+	}
+}
+
+void ContourTracer::end_compute(vector<vector<Point>>& contours_out)
+{
+	//cvFindContours puts every new external contour in front of the ones found before it
+	contours_out.resize(contour_count);
+	reverse(contours_out.begin(), contours_out.end());
+}
\ No newline at end of file
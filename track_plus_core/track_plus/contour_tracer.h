@@ -0,0 +1,51 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include "globals.h"
+#include "blob_detector_new.h"
+
+using namespace std;
+using namespace cv;
+
+//external borders with simple chain approximation, the same contours, points and order as cvFindContours with
+//CV_RETR_EXTERNAL and CV_CHAIN_APPROX_SIMPLE, written into the caller's vectors so that their capacity carries over
+class ContourTracer
+{
+public:
+	//nonzero pixels are foreground, the one pixel frame of the image counts as background like in cvFindContours
+	void compute(Mat& image_in, vector<vector<Point>>& contours_out);
+	//active blobs of the labeler are foreground, borders start from their span begins instead of a scan of the image
+	void compute(BlobDetectorNew& blob_detector, vector<vector<Point>>& contours_out);
+
+private:
+	int width;
+	int height;
+	int contour_count;
+
+	//0 off the traced borders, -126 where a border pixel has background to its right, 2 elsewhere on a border
+	vector<schar> marks;
+	vector<uchar> atlas_id_active;
+	vector<Point> seeds;
+
+	template <typename Foreground> void trace(Foreground& foreground, const int x_start, const int y_start,
+											  vector<vector<Point>>& contours_out);
+	void end_compute(vector<vector<Point>>& contours_out);
+};
\ No newline at end of file
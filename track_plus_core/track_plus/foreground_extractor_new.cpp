@@ -49,6 +49,10 @@ bool ForegroundExtractorNew::compute(Mat& image_in, MotionProcessorNew& motion_p
 
 	//------------------------------------------------------------------------------------------------------------------------
 
+	//pixels the background model has locked in are decided by it, the static background only stands in for the rest
+	Mat image_model_foreground;
+	motion_processor.background_model.classify(image_in, image_model_foreground);
+
 	image_foreground = Mat::zeros(HEIGHT_SMALL, WIDTH_SMALL, CV_8UC1);
 
 	for (int i = 0; i < WIDTH_SMALL; ++i)
@@ -59,7 +63,10 @@ bool ForegroundExtractorNew::compute(Mat& image_in, MotionProcessorNew& motion_p
 			if ((i <= x_separator_middle && gray_current > gray_threshold_left) ||
 				(i > x_separator_middle && gray_current > gray_threshold_right))
 			{
-				if (image_background_static.ptr<uchar>(j, i)[0] == 255)
+				const uchar model_foreground = image_model_foreground.ptr<uchar>(j, i)[0];
+				if (model_foreground != 255)
+					image_foreground.ptr<uchar>(j, i)[0] = model_foreground;
+				else if (image_background_static.ptr<uchar>(j, i)[0] == 255)
 					image_foreground.ptr<uchar>(j, i)[0] = 254;
 				else
 					image_foreground.ptr<uchar>(j, i)[0] = abs(gray_current - image_background_static.ptr<uchar>(j, i)[0]);
@@ -105,6 +112,8 @@ bool ForegroundExtractorNew::compute(Mat& image_in, MotionProcessorNew& motion_p
 			++active_count;
 		}
 
+	motion_processor.background_model.exclude(image_foreground);
+
 	if (active_count == 0)
 		return false;
 
@@ -148,9 +157,9 @@ bool ForegroundExtractorNew::compute(Mat& image_in, MotionProcessorNew& motion_p
 		line(image_visualization, Point(0, y_separator_up_median), Point(999, y_separator_up_median), Scalar(254), 1);
 		// line(image_visualization, Point(0, y_ref), Point(999, y_ref), Scalar(254), 1);
 
-		imshow("image_visualizationadfasdfdff" + name, image_visualization);
+		post_imshow("image_visualizationadfasdfdff" + name, image_visualization);
 	}
 
-	algo_name_vec.push_back(algo_name);
+	register_algo_name(algo_name);
 	return true;
 }
\ No newline at end of file
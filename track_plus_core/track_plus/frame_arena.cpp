@@ -0,0 +1,86 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "frame_arena.h"
+
+FrameArena::FrameArena(){}
+
+FrameArena::FrameArena(const FrameArena&){}
+
+FrameArena& FrameArena::operator=(const FrameArena&)
+{
+	return *this;
+}
+
+FrameArena::~FrameArena()
+{
+	for (unsigned char* block : blocks)
+		free(block);
+}
+
+void FrameArena::add_block(const size_t size)
+{
+	unsigned char* block = static_cast<unsigned char*>(malloc(size));
+	if (block == NULL)
+		throw bad_alloc();
+
+	blocks.push_back(block);
+	block_sizes.push_back(size);
+	offset = 0;
+	++heap_allocation_count;
+}
+
+void* FrameArena::allocate(const size_t size)
+{
+	const size_t size_aligned = (size + FRAME_ARENA_ALIGNMENT - 1) & ~(size_t)(FRAME_ARENA_ALIGNMENT - 1);
+
+	if (blocks.empty() || offset + size_aligned > block_sizes.back())
+	{
+		//at least double, a frame that keeps outgrowing its block settles after a few frames
+		size_t block_size = FRAME_ARENA_BLOCK_SIZE_MIN;
+		if (!block_sizes.empty() && block_sizes.back() * 2 > block_size)
+			block_size = block_sizes.back() * 2;
+		if (size_aligned > block_size)
+			block_size = size_aligned;
+
+		add_block(block_size);
+	}
+
+	void* ptr = blocks.back() + offset;
+	offset += size_aligned;
+	return ptr;
+}
+
+void FrameArena::reset()
+{
+	if (blocks.size() > 1)
+	{
+		size_t size_total = 0;
+		for (size_t block_size : block_sizes)
+			size_total += block_size;
+
+		for (unsigned char* block : blocks)
+			free(block);
+
+		blocks.clear();
+		block_sizes.clear();
+		add_block(size_total);
+	}
+
+	offset = 0;
+}
\ No newline at end of file
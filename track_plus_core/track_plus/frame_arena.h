@@ -0,0 +1,109 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+#include <new>
+
+using namespace std;
+
+#define FRAME_ARENA_BLOCK_SIZE_MIN (64 * 1024)
+#define FRAME_ARENA_ALIGNMENT      16
+
+//monotonic buffer for storage that lives until the next reset, deallocation is a no op and reset rewinds to empty,
+//a frame that overflowed its block has the blocks merged into one big enough so the next frames fit without mallocs
+class FrameArena
+{
+public:
+	//blocks taken from the heap since construction, left unchanged by a steady state frame
+	int heap_allocation_count = 0;
+
+	FrameArena();
+	~FrameArena();
+
+	//storage is never shared, a copy starts out empty and assigning keeps the blocks already held
+	FrameArena(const FrameArena& arena_in);
+	FrameArena& operator=(const FrameArena& arena_in);
+
+	void* allocate(const size_t size);
+	void reset();
+
+private:
+	vector<unsigned char*> blocks;
+	vector<size_t> block_sizes;
+	size_t offset = 0;
+
+	void add_block(const size_t size);
+};
+
+//stl allocator over a FrameArena, without an arena it goes to the heap, copies of a container go to the heap as well
+//so that a blob copied out of a detector stays valid after the arena is reset, moves carry the arena along
+template <typename T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+	typedef false_type propagate_on_container_copy_assignment;
+	typedef true_type propagate_on_container_move_assignment;
+	typedef false_type propagate_on_container_swap;
+
+	FrameArena* arena;
+
+	ArenaAllocator() : arena(NULL) {}
+	ArenaAllocator(FrameArena* arena_in) : arena(arena_in) {}
+	template <typename U> ArenaAllocator(const ArenaAllocator<U>& allocator_in) : arena(allocator_in.arena) {}
+
+	template <typename U> struct rebind
+	{
+		typedef ArenaAllocator<U> other;
+	};
+
+	T* allocate(const size_t n)
+	{
+		if (arena == NULL)
+			return static_cast<T*>(::operator new(n * sizeof(T)));
+
+		return static_cast<T*>(arena->allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T* ptr, const size_t)
+	{
+		if (arena == NULL)
+			::operator delete(ptr);
+	}
+
+	ArenaAllocator select_on_container_copy_construction() const
+	{
+		return ArenaAllocator();
+	}
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& allocator0, const ArenaAllocator<U>& allocator1)
+{
+	return allocator0.arena == allocator1.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& allocator0, const ArenaAllocator<U>& allocator1)
+{
+	return allocator0.arena != allocator1.arena;
+}
\ No newline at end of file
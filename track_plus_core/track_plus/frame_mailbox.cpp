@@ -0,0 +1,85 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "frame_mailbox.h"
+
+FramePool::FramePool(int width, int height)
+{
+	for (int i = 0; i < FRAME_POOL_SIZE; ++i)
+		frames[i] = new MJPEGFrame(width, height);
+}
+
+MJPEGFrame* FramePool::acquire()
+{
+	for (int i = 0; i < FRAME_POOL_SIZE; ++i)
+	{
+		int ref_count_expected = 0;
+		if (frames[i]->ref_count.compare_exchange_strong(ref_count_expected, 1))
+			return frames[i];
+	}
+	return NULL;
+}
+
+void FramePool::retain(MJPEGFrame* frame)
+{
+	++frame->ref_count;
+}
+
+void FramePool::release(MJPEGFrame* frame)
+{
+	--frame->ref_count;
+}
+
+FrameMailbox::FrameMailbox(FramePool* _frame_pool)
+{
+	frame_pool = _frame_pool;
+	slot = NULL;
+}
+
+void FrameMailbox::post(MJPEGFrame* frame)
+{
+	MJPEGFrame* frame_old = slot.exchange(frame);
+	if (frame_old != NULL)
+		frame_pool->release(frame_old);
+
+	//the consumer checks the slot while holding the mutex, taking it here keeps the notification from getting lost
+	{
+		lock_guard<mutex> lock(wake_mutex);
+	}
+	wake_condition.notify_one();
+}
+
+MJPEGFrame* FrameMailbox::take(const int timeout_ms)
+{
+	MJPEGFrame* frame = slot.exchange(NULL);
+	if (frame != NULL)
+		return frame;
+
+	unique_lock<mutex> lock(wake_mutex);
+	wake_condition.wait_for(lock, chrono::milliseconds(timeout_ms), [this]
+	{
+		return slot.load() != NULL;
+	});
+
+	return slot.exchange(NULL);
+}
+
+bool FrameMailbox::empty()
+{
+	return slot.load() == NULL;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "mjpeg_frame.h"
+
+using namespace std;
+
+#define FRAME_POOL_SIZE 4
+
+class FramePool
+{
+public:
+	MJPEGFrame* frames[FRAME_POOL_SIZE];
+
+	FramePool(int width, int height);
+
+	//returns a frame holding one reference, or NULL when every buffer is still referenced
+	MJPEGFrame* acquire();
+	void retain(MJPEGFrame* frame);
+	void release(MJPEGFrame* frame);
+};
+
+//single producer, single consumer, latest frame wins
+class FrameMailbox
+{
+public:
+	atomic<MJPEGFrame*> slot;
+
+	mutex wake_mutex;
+	condition_variable wake_condition;
+
+	FramePool* frame_pool;
+
+	FrameMailbox(FramePool* _frame_pool);
+
+	//takes over the reference of the caller, an unread frame still in the slot is released
+	void post(MJPEGFrame* frame);
+	//returns NULL on timeout, otherwise the caller owns one reference
+	MJPEGFrame* take(const int timeout_ms);
+	bool empty();
+};
\ No newline at end of file
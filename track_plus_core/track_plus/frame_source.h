@@ -0,0 +1,38 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <functional>
+#include "accelerometer_sampler.h"
+
+using namespace std;
+
+class FrameSource
+{
+public:
+	virtual ~FrameSource() {}
+
+	//timestamp is when the frame was captured, in microseconds on the same clock as the source's accelerometer readings
+	virtual bool start(function<void (unsigned char* data, unsigned long size, long long timestamp)> frame_callback) = 0;
+	virtual void stop() = 0;
+	virtual bool finished() = 0;
+
+	//up to ACCELEROMETER_SAMPLE_HISTORY readings oldest first, ending with the first one at or after timestamp
+	virtual int get_accelerometer_samples(const long long timestamp, AccelerometerSample* samples_out) = 0;
+};
\ No newline at end of file
@@ -46,7 +46,6 @@ string child_module_name = "";
 string child_module_path = "";
 
 bool play = true;
-bool waiting_for_image = true;
 bool enable_imshow = true;
 bool record_pose = false;
 bool overwrite_pose = false;
@@ -60,4 +59,12 @@ int actuate_dist_raw = 8;
 int actuate_dist = actuate_dist_raw;
 
 vector<string> algo_name_vec = vector<string>();
-vector<string> algo_name_vec_old = vector<string>();
\ No newline at end of file
+vector<string> algo_name_vec_old = vector<string>();
+
+mutex algo_name_mutex;
+
+void register_algo_name(const string algo_name)
+{
+	lock_guard<mutex> lock(algo_name_mutex);
+	algo_name_vec.push_back(algo_name);
+}
\ No newline at end of file
@@ -21,6 +21,7 @@
 #include <string>
 #include <iostream>
 #include <vector>
+#include <mutex>
 
 using namespace std;
 
@@ -63,7 +64,6 @@ extern string child_module_name;
 extern string child_module_path;
 
 extern bool play;
-extern bool waiting_for_image;
 extern bool enable_imshow;
 extern bool record_pose;
 extern bool overwrite_pose;
@@ -76,4 +76,7 @@ extern int actuate_dist_raw;
 extern int actuate_dist;
 
 extern vector<string> algo_name_vec;
-extern vector<string> algo_name_vec_old;
\ No newline at end of file
+extern vector<string> algo_name_vec_old;
+
+//both sides of the pipeline register concurrently
+void register_algo_name(const string algo_name);
\ No newline at end of file
@@ -20,21 +20,39 @@
 
 void HandResolver::compute(SCOPA& scopa0,     SCOPA& scopa1,
 						   MotionProcessorNew& motion_processor0, MotionProcessorNew& motion_processor1,
-						   Mat& image0, 					      Mat& image1,
-						   Reprojector& reprojector,              bool visualize)
+						   MJPEGFrame& frame,                     Reprojector& reprojector,
+						   bool visualize)
 {
 	Mat image_visualization0;
 	Mat image_visualization1;
 
 	if (visualize)
 	{
+		Mat image_flipped;
+		flip(frame.get_full(), image_flipped, 0);
+
+		Mat image0 = image_flipped(Rect(0, 0, WIDTH_LARGE, HEIGHT_LARGE));
+		Mat image1 = image_flipped(Rect(WIDTH_LARGE, 0, WIDTH_LARGE, HEIGHT_LARGE));
+
 		image_visualization0 = reprojector.remap(&image0, 0, true);
 		image_visualization1 = reprojector.remap(&image1, 1, true);
 	}
 
+	vector<Rect> crop_rect_vec;
+	if (scopa0.pt_index.x != -1)
+		crop_rect_vec.push_back(frame.to_coded_rect(compute_crop_rect(scopa0.pt_index), 0));
+	if (scopa1.pt_index.x != -1)
+		crop_rect_vec.push_back(frame.to_coded_rect(compute_crop_rect(scopa1.pt_index), 1));
+	if (scopa0.pt_thumb.x != -1)
+		crop_rect_vec.push_back(frame.to_coded_rect(compute_crop_rect(scopa0.pt_thumb), 0));
+	if (scopa1.pt_thumb.x != -1)
+		crop_rect_vec.push_back(frame.to_coded_rect(compute_crop_rect(scopa1.pt_thumb), 1));
+
+	frame.decode_rois(crop_rect_vec);
+
 	pt_precise_index0 = Point2f(-1, -1);
 	if (scopa0.pt_index.x != -1)
-		pt_precise_index0 = increase_resolution(scopa0.pt_index,                  image0,
+		pt_precise_index0 = increase_resolution(scopa0.pt_index,                  frame,
 											    motion_processor0.image_background_static, motion_processor0.diff_threshold,
 											    motion_processor0.gray_threshold_left,     motion_processor0.gray_threshold_right,
 											    reprojector,                               0,
@@ -42,7 +60,7 @@ void HandResolver::compute(SCOPA& scopa0,     SCOPA& scopa1,
 
 	pt_precise_index1 = Point2f(-1, -1);
 	if (scopa1.pt_index.x != -1)
-		pt_precise_index1 = increase_resolution(scopa1.pt_index,                  image1,
+		pt_precise_index1 = increase_resolution(scopa1.pt_index,                  frame,
 											    motion_processor1.image_background_static, motion_processor1.diff_threshold,
 											    motion_processor1.gray_threshold_left,     motion_processor1.gray_threshold_right,
 											    reprojector,                               1,
@@ -50,7 +68,7 @@ void HandResolver::compute(SCOPA& scopa0,     SCOPA& scopa1,
 
 	pt_precise_thumb0 = Point2f(-1, -1);
 	if (scopa0.pt_thumb.x != -1)
-		pt_precise_thumb0 = increase_resolution(scopa0.pt_thumb,                  image0,
+		pt_precise_thumb0 = increase_resolution(scopa0.pt_thumb,                  frame,
 												motion_processor0.image_background_static, motion_processor0.diff_threshold,
 												motion_processor0.gray_threshold_left,     motion_processor0.gray_threshold_right,
 												reprojector,                               0,
@@ -58,7 +76,7 @@ void HandResolver::compute(SCOPA& scopa0,     SCOPA& scopa1,
 
 	pt_precise_thumb1 = Point2f(-1, -1);
 	if (scopa1.pt_thumb.x != -1)
-		pt_precise_thumb1 = increase_resolution(scopa1.pt_thumb,                  image1,
+		pt_precise_thumb1 = increase_resolution(scopa1.pt_thumb,                  frame,
 											    motion_processor1.image_background_static, motion_processor1.diff_threshold,
 											    motion_processor1.gray_threshold_left,     motion_processor1.gray_threshold_right,
 											    reprojector,                               1,
@@ -93,11 +111,7 @@ void HandResolver::compute(SCOPA& scopa0,     SCOPA& scopa1,
 	}
 }
 
-Point2f HandResolver::increase_resolution(Point& pt_in,                    Mat& image_in,
-										  Mat& image_background_in,        const uchar diff_threshold,
-										  const uchar gray_threshold_left, const uchar gray_threshold_right,
-										  Reprojector& reprojector,        const uchar side,
-										  							       const int x_separator_middle)
+Rect HandResolver::compute_crop_rect(Point& pt_in)
 {
 	Point pt_large = pt_in * 4;
 
@@ -115,7 +129,21 @@ Point2f HandResolver::increase_resolution(Point& pt_in,                    Mat&
 	if (y1 > HEIGHT_LARGE_MINUS)
 		y1 = HEIGHT_LARGE_MINUS;
 
-	Rect crop_rect = Rect(x0, y0, x1 - x0, y1 - y0);
+	return Rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+Point2f HandResolver::increase_resolution(Point& pt_in,                    MJPEGFrame& frame,
+										  Mat& image_background_in,        const uchar diff_threshold,
+										  const uchar gray_threshold_left, const uchar gray_threshold_right,
+										  Reprojector& reprojector,        const uchar side,
+										  							       const int x_separator_middle)
+{
+	Rect crop_rect = compute_crop_rect(pt_in);
+
+	const int x0 = crop_rect.x;
+	const int y0 = crop_rect.y;
+	const int x1 = crop_rect.x + crop_rect.width;
+	const int y1 = crop_rect.y + crop_rect.height;
 
 	int crop_rect_small_width = (x1 - x0) / 4;
 	if (crop_rect_small_width > WIDTH_SMALL_MINUS)
@@ -127,11 +155,14 @@ Point2f HandResolver::increase_resolution(Point& pt_in,                    Mat&
 
 	Rect crop_rect_small = Rect(x0 / 4, y0 / 4, crop_rect_small_width, crop_rect_small_height);
 
-	Mat image_cropped = image_in(crop_rect);
+	Mat image_cropped = frame.get_roi(crop_rect, side);
+	if (image_cropped.cols == 0)
+		return Point(-1, -1);
+
 	GaussianBlur(image_cropped, image_cropped, Size(21, 21), 0, 0);
 
 	Mat image_cropped_preprocessed;
-	compute_channel_diff_image(image_cropped, image_cropped_preprocessed, true, "image_cropped_preprocessed");
+	compute_channel_diff_image(image_cropped, image_cropped_preprocessed, true);
 	Point pt_offset0;
 	image_cropped_preprocessed = reprojector.remap(&image_cropped_preprocessed, x0, y0, side, pt_offset0);
 
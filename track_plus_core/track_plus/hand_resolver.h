@@ -22,6 +22,7 @@
 #include "motion_processor_new.h"
 #include "mat_functions.h"
 #include "reprojector.h"
+#include "mjpeg_frame.h"
 
 class HandResolver
 {
@@ -40,10 +41,12 @@ public:
 
 	void compute(SCOPA& scopa0,     SCOPA& scopa1,
 				 MotionProcessorNew& motion_processor0, MotionProcessorNew& motion_processor1,
-				 Mat& image0,                           Mat& image1,
-				 Reprojector& reprojector,              bool visualize);
+				 MJPEGFrame& frame,                     Reprojector& reprojector,
+				 bool visualize);
 
-	Point2f increase_resolution(Point& pt_in,                    Mat& image_in,
+	Rect compute_crop_rect(Point& pt_in);
+
+	Point2f increase_resolution(Point& pt_in,                    MJPEGFrame& frame,
 		                        Mat& image_background_in,        const uchar diff_threshold,
 		                        const uchar gray_threshold_left, const uchar gray_threshold_right,
 								Reprojector& reprojector,        const uchar side,
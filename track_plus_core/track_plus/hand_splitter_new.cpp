@@ -18,6 +18,7 @@
 
 #include "hand_splitter_new.h"
 #include "mat_functions.h"
+#include "profile_functions.h"
 
 void set_value(float* val_old, int val_new, int val_min, int val_max)
 {
@@ -49,12 +50,7 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 
 	//------------------------------------------------------------------------------------------------------------------------
 
-	Mat image_find_contours = Mat::zeros(HEIGHT_SMALL, WIDTH_SMALL, CV_8UC1);
-	for (BlobNew& blob : *foreground_extractor.blob_detector.blobs)
-		if (blob.active)
-			blob.fill(image_find_contours, 254);
-
-	vector<vector<Point>> contours = legacyFindContours(image_find_contours);
+	contour_tracer.compute(foreground_extractor.blob_detector, contours);
 	
 	if (contours.size() == 0)
 		return false;
@@ -80,77 +76,33 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 	int intensity_array[WIDTH_SMALL] { 0 };
 	for (BlobNew& blob : *foreground_extractor.blob_detector.blobs)
 		if (blob.active)
-			for (Point& pt : blob.data)
-				++intensity_array[pt.x];
+			for (BlobSpan& span : blob.spans)
+				for (int i = span.i_begin; i <= span.i_end; ++i)
+					++intensity_array[i];
 
-	vector<Point> hist_pt_vec;
 	for (int i = 0; i < WIDTH_SMALL; ++i)
 	{
 		int j = intensity_array[i];
 		low_pass_filter->compute(j, 0.5, "histogram_j");
 
 		if (j < 10)
-			continue;
+			j = 0;
 
-		for (int j_current = 0; j_current < j; ++j_current)
-			hist_pt_vec.push_back(Point(i, j_current));
+		intensity_array[i] = j;
 	}
 
 	Point seed0 = Point(x_min, 0);
 	Point seed1 = Point(x_max, 0);
 
-	vector<Point> seed_vec0;
-	vector<Point> seed_vec1;
-
-	while (true)
-	{
-		seed_vec0.clear();
-		seed_vec1.clear();
-
-		for (Point& pt : hist_pt_vec)
-		{
-			float dist0 = get_distance(pt, seed0, false);
-			float dist1 = get_distance(pt, seed1, false);
-
-			if (dist0 < dist1)
-				seed_vec0.push_back(pt);
-			else
-				seed_vec1.push_back(pt);
-		}
-
-		if (seed_vec0.size() == 0 || seed_vec1.size() == 0)
-			break;
-
-		Point seed0_new = Point(0, 0);
-		for (Point& pt : seed_vec0)
-		{
-			seed0_new.x += pt.x;
-			seed0_new.y += pt.y;
-		}
-		seed0_new.x /= seed_vec0.size();
-		seed0_new.y /= seed_vec0.size();
-
-		Point seed1_new = Point(0, 0);
-		for (Point& pt : seed_vec1)
-		{
-			seed1_new.x += pt.x;
-			seed1_new.y += pt.y;
-		}
-		seed1_new.x /= seed_vec1.size();
-		seed1_new.y /= seed_vec1.size();
-
-		if (seed0 == seed0_new && seed1 == seed1_new)
-			break;
-
-		seed0 = seed0_new;
-		seed1 = seed1_new;
-	}
+	int x_seed_vec0_max_new;
+	int x_seed_vec1_min_new;
+	const bool split = split_profile(intensity_array, WIDTH_SMALL, seed0, seed1, x_seed_vec0_max_new, x_seed_vec1_min_new);
 
 	bool dual = false;
-	if (seed_vec0.size() > 0 && seed_vec1.size() > 0)
+	if (split)
 	{
-		x_seed_vec0_max = seed_vec0[seed_vec0.size() - 1].x;
-		x_seed_vec1_min = seed_vec1[0].x;
+		x_seed_vec0_max = x_seed_vec0_max_new;
+		x_seed_vec1_min = x_seed_vec1_min_new;
 
 		low_pass_filter->compute_if_smaller(x_seed_vec0_max, 0.5, "x_seed_vec0_max");
 		low_pass_filter->compute_if_larger(x_seed_vec1_min, 0.5, "x_seed_vec1_min");
@@ -198,8 +150,8 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 
 	//------------------------------------------------------------------------------------------------------------------------
 
-	int count_left = 0;
-	int count_right = 0;
+	int pixel_count_left = 0;
+	int pixel_count_right = 0;
 
 	int x_min_left = 9999;
 	int x_max_left = 0;
@@ -209,23 +161,30 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 	for (BlobNew& blob : *foreground_extractor.blob_detector.blobs)
 		if (blob.active)
 		{
-			for (Point& pt : blob.data)
-				if (pt.x < motion_processor.x_separator_middle)
+			//last column left of x_separator_middle
+			const int i_left = ceil(motion_processor.x_separator_middle) - 1;
+
+			for (BlobSpan& span : blob.spans)
+			{
+				if (span.i_begin <= i_left)
 				{
-					++count_left;
-					if (pt.x < x_min_left)
-						x_min_left = pt.x;
-					if (pt.x > x_max_left)
-						x_max_left = pt.x;
+					const int i_end = min(span.i_end, i_left);
+					pixel_count_left += i_end - span.i_begin + 1;
+					if (span.i_begin < x_min_left)
+						x_min_left = span.i_begin;
+					if (i_end > x_max_left)
+						x_max_left = i_end;
 				}
-				else
+				if (span.i_end > i_left)
 				{
-					++count_right;
-					if (pt.x < x_min_right)
-						x_min_right = pt.x;
-					if (pt.x > x_max_right)
-						x_max_right = pt.x;
+					const int i_begin = max(span.i_begin, i_left + 1);
+					pixel_count_right += span.i_end - i_begin + 1;
+					if (i_begin < x_min_right)
+						x_min_right = i_begin;
+					if (span.i_end > x_max_right)
+						x_max_right = span.i_end;
 				}
+			}
 		}
 
 	int width_left = x_max_left - x_min_left;
@@ -239,8 +198,8 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 
 	if (!dual && dual_old)
 	{
-		float count_small = reference_is_left ? count_right : count_left;
-		float count_large = reference_is_left ? count_left : count_right;
+		float count_small = reference_is_left ? pixel_count_right : pixel_count_left;
+		float count_large = reference_is_left ? pixel_count_left : pixel_count_right;
 
 		if (count_small / count_large > 0.5)
 		{
@@ -267,7 +226,7 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 			set_value(&motion_processor.x_separator_middle, (x_seed_vec1_min + x_seed_vec0_max) / 2, 0, WIDTH_SMALL_MINUS);
 		}
 
-		reference_is_left = count_left > count_right;
+		reference_is_left = pixel_count_left > pixel_count_right;
 		value_store.set_bool("reference_is_left", reference_is_left);
 
 		if (!algo_name_found || do_reset)
@@ -329,25 +288,11 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 
 	if (merge || dual)
 	{
-		seed_left = Point(0, 0);
-		int seed_left_count = 0;
-		for (BlobNew& blob : blobs_left)
-			for (Point& pt : blob.data)
-			{
-				seed_left.x += pt.x;
-				seed_left.y += pt.y;
-				++seed_left_count;
-			}
+		seed_left = pt_sum_left;
+		const int seed_left_count = count_left;
 		
-		seed_right = Point(0, 0);
-		int seed_right_count = 0;
-		for (BlobNew& blob : blobs_right)
-			for (Point& pt : blob.data)
-			{
-				seed_right.x += pt.x;
-				seed_right.y += pt.y;
-				++seed_right_count;
-			}
+		seed_right = pt_sum_right;
+		const int seed_right_count = count_right;
 
 		if (seed_left_count > 0 && seed_right_count > 0)
 		{
@@ -357,45 +302,41 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 			seed_right.x /= seed_right_count;
 			seed_right.y /= seed_right_count;
 
-			vector<Point> seed_left_vec;
-			vector<Point> seed_right_vec;
-
 			while (true)
 			{
-				seed_left_vec.clear();
-				seed_right_vec.clear();				
+				//only the sums of each side feed the next seeds
+				Point seed_left_new = Point(0, 0);
+				Point seed_right_new = Point(0, 0);
+				int seed_left_new_count = 0;
+				int seed_right_new_count = 0;
 
 				for (BlobNew& blob : *foreground_extractor.blob_detector.blobs)
 					if (blob.active)
-						for (Point& pt : blob.data)
-						{
-							float dist_left = get_distance(pt, seed_left, false);
-							float dist_right = get_distance(pt, seed_right, false);
-							if (dist_left < dist_right)
-								seed_left_vec.push_back(pt);
-							else
-								seed_right_vec.push_back(pt);
-						}
-
-				if (seed_left_vec.size() > 0 && seed_right_vec.size() > 0)
+						for (BlobSpan& span : blob.spans)
+							for (int i = span.i_begin; i <= span.i_end; ++i)
+							{
+								const Point pt = Point(i, span.j);
+								float dist_left = get_distance(pt, seed_left, false);
+								float dist_right = get_distance(pt, seed_right, false);
+								if (dist_left < dist_right)
+								{
+									seed_left_new += pt;
+									++seed_left_new_count;
+								}
+								else
+								{
+									seed_right_new += pt;
+									++seed_right_new_count;
+								}
+							}
+
+				if (seed_left_new_count > 0 && seed_right_new_count > 0)
 				{
-					Point seed_left_new = Point(0, 0);
-					for (Point& pt : seed_left_vec)
-					{
-						seed_left_new.x += pt.x;
-						seed_left_new.y += pt.y;
-					}
-					seed_left_new.x /= seed_left_vec.size();
-					seed_left_new.y /= seed_left_vec.size();
+					seed_left_new.x /= seed_left_new_count;
+					seed_left_new.y /= seed_left_new_count;
 
-					Point seed_right_new = Point(0, 0);
-					for (Point& pt : seed_right_vec)
-					{
-						seed_right_new.x += pt.x;
-						seed_right_new.y += pt.y;
-					}
-					seed_right_new.x /= seed_right_vec.size();
-					seed_right_new.y /= seed_right_vec.size();
+					seed_right_new.x /= seed_right_new_count;
+					seed_right_new.y /= seed_right_new_count;
 
 					if (seed_left.x == seed_left_new.x && seed_left.y == seed_left_new.y &&
 						seed_right.x == seed_right_new.x && seed_right.y == seed_right_new.y)
@@ -470,10 +411,19 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 	y_min_result_left = 9999;
 	y_max_result_left = -1;
 
-	blobs_right.clear();
-	blobs_left.clear();
+	blobs = foreground_extractor.blob_detector.blobs;
+	blob_indices_right.clear();
+	blob_indices_left.clear();
 
-	for (BlobNew& blob : *foreground_extractor.blob_detector.blobs)
+	pt_sum_right = Point(0, 0);
+	pt_sum_left = Point(0, 0);
+	count_right = 0;
+	count_left = 0;
+
+	const int blob_count = blobs->size();
+	for (int index = 0; index < blob_count; ++index)
+	{
+		BlobNew& blob = (*blobs)[index];
 		if (blob.active)
 		{
 			if (blob.x > motion_processor.x_separator_middle)
@@ -487,7 +437,9 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 				if (blob.y_max > y_max_result_right)
 					y_max_result_right = blob.y_max;
 
-				blobs_right.push_back(blob);
+				blob_indices_right.push_back(index);
+				pt_sum_right += Point(blob.x_sum, blob.y_sum);
+				count_right += blob.count;
 			}
 			else
 			{
@@ -500,9 +452,12 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 				if (blob.y_max > y_max_result_left)
 					y_max_result_left = blob.y_max;
 
-				blobs_left.push_back(blob);
+				blob_indices_left.push_back(index);
+				pt_sum_left += Point(blob.x_sum, blob.y_sum);
+				count_left += blob.count;
 			}
 		}
+	}
 
 	//------------------------------------------------------------------------------------------------------------------------
 
@@ -519,7 +474,7 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 		line(image_visualization, Point(0, y_separator_down_median), Point(999, y_separator_down_median), Scalar(254), 1);
 		line(image_visualization, Point(0, y_separator_up_median), Point(999, y_separator_up_median), Scalar(254), 1);
 
-		imshow("image_visualizationsdlkfjhasdf" + name, image_visualization);
+		post_imshow("image_visualizationsdlkfjhasdf" + name, image_visualization);
 	}
 
 	int width_result_left = x_max_result_left - x_min_result_left;
@@ -527,11 +482,31 @@ bool HandSplitterNew::compute(ForegroundExtractorNew& foreground_extractor, Moti
 	if (width_result_left > WIDTH_SMALL * 0.7 || width_result_right > WIDTH_SMALL * 0.7)
 		return false;
 
-	if (blobs_right.size() > 0 || blobs_left.size() > 0)
+	if (blob_indices_right.size() > 0 || blob_indices_left.size() > 0)
 	{
-		algo_name_vec.push_back(algo_name);
+		register_algo_name(algo_name);
 		return true;
 	}
 
 	return false;
+}
+
+HandSplitterResult HandSplitterNew::get_result_right()
+{
+	HandSplitterResult result;
+	if (blobs != NULL)
+	{
+		result.blobs_right.reserve(blob_indices_right.size());
+		for (int index : blob_indices_right)
+		{
+			result.blobs_right.push_back((*blobs)[index]);
+			result.blobs_right.back().image_atlas.release();
+		}
+	}
+
+	result.x_min_result_right = x_min_result_right;
+	result.x_max_result_right = x_max_result_right;
+	result.y_min_result_right = y_min_result_right;
+	result.y_max_result_right = y_max_result_right;
+	return result;
 }
\ No newline at end of file
@@ -20,6 +20,18 @@
 
 #include "motion_processor_new.h"
 #include "foreground_extractor_new.h"
+#include "contour_tracer.h"
+
+//the right hand as SCOPA reads it, the one copy of the blobs made per frame so the splitter can go on with the next frame
+struct HandSplitterResult
+{
+	vector<BlobNew> blobs_right;
+
+	int x_min_result_right = 0;
+	int x_max_result_right = 0;
+	int y_min_result_right = 0;
+	int y_max_result_right = 0;
+};
 
 class HandSplitterNew
 {
@@ -29,8 +41,21 @@ public:
 	ValueStore value_store;
 	ValueAccumulator value_accumulator;
 
-	vector<BlobNew> blobs_right;
-	vector<BlobNew> blobs_left;
+	//external contours of the active foreground blobs, traced from the labels and refilled every compute
+	ContourTracer contour_tracer;
+	vector<vector<Point>> contours;
+
+	//foreground blobs of the last compute and the ones on each side as indices into them, valid until the foreground
+	//extractor computes again
+	vector<BlobNew>* blobs = NULL;
+	vector<int> blob_indices_right;
+	vector<int> blob_indices_left;
+
+	//pixel sums of each side, the next frame seeds the split from them
+	Point pt_sum_right = Point(0, 0);
+	Point pt_sum_left = Point(0, 0);
+	int count_right = 0;
+	int count_left = 0;
 
 	int x_min_result_right = 0;
 	int x_max_result_right = 0;
@@ -43,4 +68,5 @@ public:
 	int y_max_result_left = 0;
 
 	bool compute(ForegroundExtractorNew& foreground_extractor, MotionProcessorNew& motion_processor, string name, bool visualize);
+	HandSplitterResult get_result_right();
 };
\ No newline at end of file
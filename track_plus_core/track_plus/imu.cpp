@@ -38,4 +38,28 @@ void IMU::compute(float x_accel, float y_accel, float z_accel)
 	low_pass_filter.compute(roll, 0.01, "roll");
 	low_pass_filter.compute(pitch, 0.01, "pitch");
 	low_pass_filter.compute(yaw, 0.01, "yaw");
+}
+
+void IMU::compute(AccelerometerSample* samples, const int sample_count, const long long timestamp)
+{
+	if (sample_count <= 0)
+		return;
+
+	int index_after = 0;
+	while (index_after < sample_count && samples[index_after].timestamp <= timestamp)
+		++index_after;
+
+	AccelerometerSample& sample_before = samples[max(index_after - 1, 0)];
+	AccelerometerSample& sample_after = samples[min(index_after, sample_count - 1)];
+
+	float alpha = 1;
+	if (sample_after.timestamp > sample_before.timestamp)
+	{
+		alpha = (float)(timestamp - sample_before.timestamp) / (sample_after.timestamp - sample_before.timestamp);
+		alpha = max(0.0f, min(1.0f, alpha));
+	}
+
+	compute(sample_before.x + (sample_after.x - sample_before.x) * alpha,
+			sample_before.y + (sample_after.y - sample_before.y) * alpha,
+			sample_before.z + (sample_after.z - sample_before.z) * alpha);
 }
\ No newline at end of file
@@ -20,6 +20,7 @@
 
 #include <opencv2/opencv.hpp>
 #include "low_pass_filter.h"
+#include "accelerometer_sampler.h"
 
 using namespace cv;
 
@@ -34,4 +35,7 @@ public:
 
 	Point3f compute_azimuth(float accel_x, float accel_y, float accel_z);
 	void compute(float accel_x, float accel_y, float accel_z);
+	//interpolates between the two readings around the given timestamp, samples oldest first, timestamps outside them use
+	//the nearest reading
+	void compute(AccelerometerSample* samples, const int sample_count, const long long timestamp);
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "job_worker.h"
+
+void JobWorker::submit(function<bool ()> _job)
+{
+	{
+		lock_guard<mutex> lock(job_mutex);
+		job = _job;
+		job_pending = true;
+	}
+	job_condition.notify_all();
+
+	if (worker_thread == NULL)
+	{
+		worker_thread = new thread(&JobWorker::run, this);
+		worker_thread->detach();
+	}
+}
+
+bool JobWorker::wait()
+{
+	unique_lock<mutex> lock(job_mutex);
+	job_condition.wait(lock, [this]
+	{
+		return !job_pending;
+	});
+
+	return job_result;
+}
+
+void JobWorker::run()
+{
+	unique_lock<mutex> lock(job_mutex);
+	while (true)
+	{
+		job_condition.wait(lock, [this]
+		{
+			return job_pending;
+		});
+
+		lock.unlock();
+		const bool result = job();
+		lock.lock();
+
+		job_result = result;
+		job_pending = false;
+		job_condition.notify_all();
+	}
+}
+
+void JobGate::close()
+{
+	lock_guard<mutex> lock(gate_mutex);
+	opened = false;
+}
+
+void JobGate::open()
+{
+	{
+		lock_guard<mutex> lock(gate_mutex);
+		opened = true;
+	}
+	gate_condition.notify_all();
+}
+
+void JobGate::wait()
+{
+	unique_lock<mutex> lock(gate_mutex);
+	gate_condition.wait(lock, [this]
+	{
+		return opened;
+	});
+}
\ No newline at end of file
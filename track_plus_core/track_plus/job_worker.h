@@ -0,0 +1,58 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+//runs one job at a time on a persistent thread so the caller can do the other half of the work meanwhile
+class JobWorker
+{
+public:
+	thread* worker_thread = NULL;
+
+	mutex job_mutex;
+	condition_variable job_condition;
+
+	function<bool ()> job;
+	bool job_pending = false;
+	bool job_result = false;
+
+	void submit(function<bool ()> _job);
+	bool wait();
+	void run();
+};
+
+//lets one side of a concurrent stage block until the other side has published what it reads, open unless closed
+class JobGate
+{
+public:
+	mutex gate_mutex;
+	condition_variable gate_condition;
+
+	bool opened = true;
+
+	void close();
+	void open();
+	void wait();
+};
\ No newline at end of file
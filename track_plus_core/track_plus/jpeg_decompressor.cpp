@@ -17,9 +17,53 @@
  */
 
 #include "jpeg_decompressor.h"
-#ifdef _WIN32
-bool JPEGDecompressor::compute(unsigned char * in, unsigned long in_len, unsigned char * out, int width, int height)
+
+bool JPEGDecompressor::compute(unsigned char * in, unsigned long in_len, unsigned char * out, int width, int height, int pixel_format)
+{
+	return tjDecompress2(handle, in, in_len, out, width, width * tjPixelSize[pixel_format], height, pixel_format, 0) == 0;
+}
+
+bool JPEGDecompressor::compute_planes(unsigned char* in, unsigned long in_len, unsigned char** planes, int* strides, int width, int height)
 {
-	return tjDecompress2(handle, in, in_len, out, width, width * 3, height, TJPF_BGR, 0) == 0;
+	return tjDecompressToYUVPlanes(handle, in, in_len, planes, width, strides, height, 0) == 0;
 }
-#endif
\ No newline at end of file
+
+bool JPEGDecompressor::get_subsampling(unsigned char* in, unsigned long in_len, int& subsampling)
+{
+	int width;
+	int height;
+	return tjDecompressHeader2(handle, in, in_len, &width, &height, &subsampling) == 0;
+}
+
+bool JPEGDecompressor::compute_crop(unsigned char* in, unsigned long in_len, vector<tjregion>& regions, vector<unsigned char*>& outs)
+{
+	const int count = regions.size();
+	if (count == 0)
+		return true;
+
+	vector<tjtransform> transforms(count);
+	vector<unsigned char*> crop_bufs(count, NULL);
+	vector<unsigned long> crop_lens(count, 0);
+
+	for (int i = 0; i < count; ++i)
+	{
+		memset(&transforms[i], 0, sizeof(tjtransform));
+		transforms[i].r = regions[i];
+		transforms[i].op = TJXOP_NONE;
+		transforms[i].options = TJXOPT_CROP;
+	}
+
+	bool result = tjTransform(handle_transform, in, in_len, count, &crop_bufs[0], &crop_lens[0], &transforms[0], 0) == 0;
+
+	for (int i = 0; i < count; ++i)
+	{
+		if (result)
+			result = tjDecompress2(handle, crop_bufs[i], crop_lens[i], outs[i],
+								   regions[i].w, regions[i].w * 3, regions[i].h, TJPF_BGR, 0) == 0;
+
+		if (crop_bufs[i] != NULL)
+			tjFree(crop_bufs[i]);
+	}
+
+	return result;
+}
\ No newline at end of file
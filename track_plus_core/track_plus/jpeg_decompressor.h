@@ -18,14 +18,26 @@
 
 #pragma once
 
-#ifdef _WIN32
+#include <vector>
+#include <cstring>
 #include "turbojpeg.h"
 
+using namespace std;
+
 class JPEGDecompressor
 {
 public:
 	tjhandle handle = tjInitDecompress();
+	tjhandle handle_transform = tjInitTransform();
+
+	//width and height smaller than the coded size select the matching libjpeg-turbo scaling factor (1/2, 1/4, 1/8),
+	//which shrinks the IDCT itself instead of decoding at full size and resizing
+	bool compute(unsigned char * in, unsigned long in_len,unsigned char * out, int width, int height, int pixel_format = TJPF_BGR);
+	//planar YCbCr straight out of the IDCT, no upsampling or color conversion, scaling works the same way as in compute
+	bool compute_planes(unsigned char* in, unsigned long in_len, unsigned char** planes, int* strides, int width, int height);
+	bool get_subsampling(unsigned char* in, unsigned long in_len, int& subsampling);
 
-	bool compute(unsigned char * in, unsigned long in_len,unsigned char * out, int width, int height);
-};
-#endif
\ No newline at end of file
+	//regions must start on MCU boundaries, they are cropped losslessly in the DCT domain with a single entropy decoding pass
+	//and only the cropped MCUs go through IDCT and color conversion, each out buffer receives w * h BGR pixels
+	bool compute_crop(unsigned char* in, unsigned long in_len, vector<tjregion>& regions, vector<unsigned char*>& outs);
+};
\ No newline at end of file
@@ -19,13 +19,20 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/calib3d/calib3d.hpp>
 #include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 #include "globals.h"
 #include "ipc.h"
 #include "camera.h"
+#include "session_recorder.h"
+#include "session_player.h"
 #include "imu.h"
 #include "surface_computer.h"
 #include "mat_functions.h"
+#include "preprocessor.h"
 #include "camera_initializer_new.h"
 #include "motion_processor_new.h"
 #include "foreground_extractor_new.h"
@@ -38,6 +45,9 @@
 #include "pointer_mapper.h"
 #include "processes.h"
 #include "console_log.h"
+#include "spsc_queue.h"
+
+#define PIPELINE_QUEUE_SIZE 2
 
 #ifdef _WIN32
 #include <VersionHelpers.h>
@@ -70,10 +80,15 @@ IPC* ipc = NULL;
 
 Camera* camera = NULL;
 
+SessionRecorder* session_recorder = NULL;
+SessionPlayer* session_player = NULL;
+
 IMU imu;
 
 SurfaceComputer surface_computer;
 
+Preprocessor preprocessor;
+
 MotionProcessorNew motion_processor0;
 MotionProcessorNew motion_processor1;
 
@@ -88,6 +103,9 @@ SCOPA scopa1;
 
 PoseEstimator pose_estimator;
 
+JobWorker side_worker_motion;
+JobWorker side_worker_scopa;
+
 Reprojector reprojector;
 
 HandResolver hand_resolver;
@@ -100,33 +118,81 @@ LowPassFilter low_pass_filter;
 
 const int pool_size_max = 100;
 
-Mat image_pool[pool_size_max];
-int image_pool_count = 0;
-Mat image_current_frame;
-
 vector<Point> point_vec_pool[pool_size_max];
 int point_vec_pool_count = 0;
 vector<Point>* point_vec_ptr = NULL;
 
 bool serial_verified = false;
-bool updated = false;
+bool headless = false;
 
 int wait_count = 0;
 int frame_count = 0;
+
+//frames flow preprocess (tracking thread) -> motion, foreground, hand split -> SCOPA, stereo, output,
+//each stage owns the state of its algorithms so different frames can be in different stages at once
+struct MotionStageItem
+{
+    int exposure_epoch = 0;
+    bool normalized = false;
+
+    //handed back to the ring once the motion stage is done with the frame
+    PreprocessorSlot* preprocessor_slot = NULL;
+
+    int y_reflection = HEIGHT_SMALL;
+    float pitch = 0;
+};
+
+struct ScopaStageItem
+{
+    bool proceed = false;
+
+    HandSplitterResult hand_splitter_result[2];
+};
+
+SPSCQueue<MotionStageItem, PIPELINE_QUEUE_SIZE> motion_stage_queue;
+SPSCQueue<ScopaStageItem, PIPELINE_QUEUE_SIZE> scopa_stage_queue;
+
+//frames handed to the motion stage that have not left the pipeline yet
+atomic<int> pipeline_pending(0);
+
+//the queue holds at most PIPELINE_QUEUE_SIZE frames and the motion stage works on one more, so a slot is always free
+//by the time the tracking thread preprocesses the next frame
+PreprocessorSlot preprocessor_slots[PIPELINE_QUEUE_SIZE + 2];
+
+//the tracking thread sleeps on this while the motion stage still holds every slot
+mutex preprocessor_slot_mutex;
+condition_variable preprocessor_slot_released;
+
+//cleared on exit front to back, so the motion stage never pushes into a queue nobody pops anymore
+atomic<bool> motion_stage_running(false);
+atomic<bool> scopa_stage_running(false);
+thread motion_stage_thread;
+thread scopa_stage_thread;
+
+//feedback against the direction of the pipeline, picked up by the earlier stage on its next frame
+atomic<bool> exposure_reset_requested(false);
+atomic<bool> scopa_proceeded(false);
 //
 
+void stop_pipeline();
+
 void do_exit(bool kill_child)
 {
     if (child_module_name != "" && kill_child)
         ipc->send_message(child_module_name, "exit", "");
 
     ipc->clear();
+
+    if (session_recorder != NULL)
+        session_recorder->close();
         
 #ifdef __APPLE__
     if (camera != NULL)
         camera->stopVideoStream();
 #endif
 
+    stop_pipeline();
+
     console_log("exit");
     exit(0);
 }
@@ -193,19 +259,8 @@ void wait_for_device()
     }
 }
 
-void update(Mat& image_in, bool dummy_tick)
+void update(bool)
 {
-    if (!dummy_tick)
-    {
-        image_pool[image_pool_count] = image_in;
-        image_current_frame = image_pool[image_pool_count];
-        
-        ++image_pool_count;
-        if (image_pool_count == pool_size_max)
-            image_pool_count = 0;
-
-        updated = true;
-    }
     wait_count = 0;
 }
 
@@ -244,8 +299,22 @@ void load_settings()
     }
 }
 
+void setup_on_first_frame_headless()
+{
+    console_log("on first frame (replay)");
+
+    CameraInitializerNew::init(camera);
+    pose_estimator.init();
+}
+
 void setup_on_first_frame()
 {
+    if (headless)
+    {
+        setup_on_first_frame_headless();
+        return;
+    }
+
     console_log("on first frame");
 
     ipc->send_message("menu_plus", "set status", "verifying serial number");
@@ -330,23 +399,211 @@ void left_mouse_cb(int event, int x, int y, int flags, void* userdata)
         console_log(to_string(x) + ", " + to_string(y) + " " + to_string(imu.pitch));
 }
 
-bool compute()
+//side 1 runs on side_worker while side 0 runs on the calling thread, both results are in once this returns
+void compute_sides(JobWorker& side_worker, function<bool ()> job0, function<bool ()> job1, bool& result0, bool& result1)
 {
-    bool waiting_for_image_set = false;
-    updated = false;
-    ++frame_count;
+    side_worker.submit(job1);
+    result0 = job0();
+    result1 = side_worker.wait();
+}
+
+void compute_motion_stage(MotionStageItem& item)
+{
+    //frames preprocessed before the exposure reset this stage asked for never reach the algorithms
+    static int exposure_epoch_required = 0;
+    if (item.exposure_epoch < exposure_epoch_required)
+    {
+        --pipeline_pending;
+        return;
+    }
+
+    if (scopa_proceeded)
+    {
+        motion_processor0.target_frame = 10;
+        motion_processor1.target_frame = 10;
+    }
+
+    algo_name_vec_old = algo_name_vec;
+    algo_name_vec.clear();
+
+    static bool motion_processor_proceed = false;
+    static bool construct_background = false;
+    static bool first_pass = true;
+
+    bool proceed0 = false;
+    bool proceed1 = false;
+
+    if (item.normalized)
+    {
+        motion_processor_stereo.gate_moving.close();
+        motion_processor_stereo.gate_thresholds.close();
+        compute_sides(side_worker_motion, [&]
+        {
+            PreprocessorSlot& slot = *item.preprocessor_slot;
+            const bool result = motion_processor0.compute(slot.image_preprocessed[0], slot.image_preprocessed_small[0], slot.image_small[0],
+                                                          item.y_reflection, item.pitch, construct_background, "0", true);
+            motion_processor_stereo.gate_moving.open();
+            motion_processor_stereo.gate_thresholds.open();
+            return result;
+        },
+        [&]
+        {
+            PreprocessorSlot& slot = *item.preprocessor_slot;
+            return motion_processor1.compute(slot.image_preprocessed[1], slot.image_preprocessed_small[1], slot.image_small[1],
+                                             item.y_reflection, item.pitch, construct_background, "1", false);
+        }, proceed0, proceed1);
+    }
+
+    if (first_pass && motion_processor0.both_moving && motion_processor1.both_moving)
+    {
+        console_log("readjusting exposure");
+
+        first_pass = false;
+        exposure_epoch_required = item.exposure_epoch + 1;
+        exposure_reset_requested = true;
+    }
+    else if (!first_pass)
+        construct_background = true;
+
+    if (!construct_background)
+    {
+        proceed0 = false;
+        proceed1 = false;            
+    }
+
+    if (proceed0 && proceed1)
+    {
+        motion_processor_proceed = true;
+        Camera::motion_gate.enabled = true;
+    }
+
+    bool proceed = motion_processor_proceed;
+
+    static bool menu_plus_signal0 = false;
+    if (!menu_plus_signal0)
+    {
+        menu_plus_signal0 = true;
+        // ipc->send_message("menu_plus", "hide window", "");
+    }
+
+    if (proceed)
+    {
+        compute_sides(side_worker_motion,
+                      [&] { return foreground_extractor0.compute(item.preprocessor_slot->image_preprocessed[0], motion_processor0, "0", true); },
+                      [&] { return foreground_extractor1.compute(item.preprocessor_slot->image_preprocessed[1], motion_processor1, "1", false); },
+                      proceed0, proceed1);
+        proceed = proceed0 && proceed1;
+    }
+
+    if (proceed)
+    {
+        compute_sides(side_worker_motion,
+                      [&] { return hand_splitter0.compute(foreground_extractor0, motion_processor0, "0", false); },
+                      [&] { return hand_splitter1.compute(foreground_extractor1, motion_processor1, "1", false); },
+                      proceed0, proceed1);
+        proceed = proceed0 && proceed1;
+    }
+
+    ScopaStageItem scopa_item;
+    scopa_item.proceed = proceed;
+
+    if (proceed)
+    {
+        scopa_item.hand_splitter_result[0] = hand_splitter0.get_result_right();
+        scopa_item.hand_splitter_result[1] = hand_splitter1.get_result_right();
+    }
+
+    scopa_stage_queue.push(move(scopa_item));
+}
+
+void compute_scopa_stage(ScopaStageItem& item)
+{
+    SCOPA::next_frame();
+
+    bool proceed = item.proceed;
+
+    if (proceed)
+    {
+        bool proceed0;
+        bool proceed1;
+
+        scopa_stereo.gate_palm_radius.close();
+        scopa_stereo.gate_hand_angle.close();
+        compute_sides(side_worker_scopa,
+                      [&] { return scopa0.compute_mono0(item.hand_splitter_result[0], pose_estimator, "0", false); },
+                      [&]
+                      {
+                          const bool result = scopa1.compute_mono0(item.hand_splitter_result[1], pose_estimator, "1", false);
+                          scopa_stereo.gate_palm_radius.open();
+                          scopa_stereo.gate_hand_angle.open();
+                          return result;
+                      }, proceed0, proceed1);
+        proceed = proceed0 && proceed1;
+    }
+
+    if (proceed)
+    {
+        scopa_proceeded = true;
+
+        SCOPA::compute_stereo();
+        scopa1.compute_mono1("1");
+        scopa0.compute_mono1("0");
+    }
+
+    --pipeline_pending;
+}
+
+void motion_stage_thread_function()
+{
+    while (motion_stage_running)
+    {
+        MotionStageItem item;
+        if (motion_stage_queue.pop(item, 100))
+        {
+            compute_motion_stage(item);
+
+            {
+                lock_guard<mutex> lock(preprocessor_slot_mutex);
+                item.preprocessor_slot->in_use = false;
+            }
+            preprocessor_slot_released.notify_one();
+        }
+    }
+}
 
-    if (image_current_frame.cols == 0)
+void scopa_stage_thread_function()
+{
+    while (scopa_stage_running)
     {
-        console_log("bad frame");
-        return false;
+        ScopaStageItem item;
+        if (scopa_stage_queue.pop(item, 100))
+            compute_scopa_stage(item);
     }
+}
 
-    Mat image_flipped;
-    flip(image_current_frame, image_flipped, 0);
+void start_pipeline()
+{
+    motion_stage_running = true;
+    scopa_stage_running = true;
 
-    Mat image0 = image_flipped(Rect(0, 0, 640, 480));
-    Mat image1 = image_flipped(Rect(640, 0, 640, 480));
+    motion_stage_thread = thread(motion_stage_thread_function);
+    scopa_stage_thread = thread(scopa_stage_thread_function);
+}
+
+void stop_pipeline()
+{
+    motion_stage_running = false;
+    if (motion_stage_thread.joinable() && motion_stage_thread.get_id() != this_thread::get_id())
+        motion_stage_thread.join();
+
+    scopa_stage_running = false;
+    if (scopa_stage_thread.joinable() && scopa_stage_thread.get_id() != this_thread::get_id())
+        scopa_stage_thread.join();
+}
+
+void compute(MJPEGFrame& frame)
+{
+    ++frame_count;
 
     if (frame_count == 1)
         setup_on_first_frame();
@@ -354,43 +611,71 @@ bool compute()
     if (!play || settings.touch_control != "1")
     {
         if (enable_imshow)
+        {
+            show_posted_images();
             waitKey(1);
+        }
 
-        return false;
+        return;
     }
 
-    int x_accel;
-    int y_accel;
-    int z_accel;
-    camera->getAccelerometerValues(&x_accel, &y_accel, &z_accel);
-    imu.compute(x_accel, y_accel, z_accel);
+    AccelerometerSample accelerometer_samples[ACCELEROMETER_SAMPLE_HISTORY];
+    const int accelerometer_sample_count = camera->getAccelerometerSamples(frame.timestamp, accelerometer_samples);
+    imu.compute(accelerometer_samples, accelerometer_sample_count, frame.timestamp);
 
     //----------------------------------------core algorithm----------------------------------------
 
-    Mat image_small0;
-    Mat image_small1;
-    resize(image0, image_small0, Size(160, 120), 0, 0, INTER_LINEAR);
-    resize(image1, image_small1, Size(160, 120), 0, 0, INTER_LINEAR);
+    static bool exposure_set = false;
+    static int exposure_epoch = 0;
 
-    Mat image_preprocessed0;
-    Mat image_preprocessed1;
+    PreprocessorSlot* preprocessor_slot = NULL;
+    {
+        unique_lock<mutex> lock(preprocessor_slot_mutex);
+        preprocessor_slot_released.wait(lock, [&preprocessor_slot]
+        {
+            for (PreprocessorSlot& slot : preprocessor_slots)
+                if (!slot.in_use)
+                {
+                    preprocessor_slot = &slot;
+                    return true;
+                }
 
-    static bool exposure_set = false;
+            return false;
+        });
+    }
 
-    bool normalized = compute_channel_diff_image(image_small0, image_preprocessed0, exposure_set, "image_preprocessed0", true, exposure_set);
-                      compute_channel_diff_image(image_small1, image_preprocessed1, exposure_set, "image_preprocessed1");
+    bool normalized = preprocessor.compute(frame, *preprocessor_slot, Camera::decode_yuv, exposure_set, true, exposure_set);
 
-    GaussianBlur(image_preprocessed0, image_preprocessed0, Size(3, 9), 0, 0);
-    GaussianBlur(image_preprocessed1, image_preprocessed1, Size(3, 9), 0, 0);
+    Mat image_small0 = preprocessor_slot->image_small[0];
+    Mat image_small1 = preprocessor_slot->image_small[1];
+    Mat image_preprocessed0 = preprocessor_slot->image_preprocessed[0];
+    Mat image_preprocessed1 = preprocessor_slot->image_preprocessed[1];
+
+    //the motion stage saw both hands moving on the first pass, frames preprocessed before this point are dropped there
+    if (exposure_reset_requested.exchange(false))
+    {
+        exposure_set = false;
+        mat_functions_low_pass_filter.reset();
+
+        CameraInitializerNew::adjust_exposure(camera, image_preprocessed0, true);
+        ++exposure_epoch;
+        return;
+    }
 
     if (!CameraInitializerNew::adjust_exposure(camera, image_preprocessed0))
     {
         static int step_count = 0;
         if (step_count == 3)
+        {
+            Mat image_full_flipped;
+            flip(frame.get_full(), image_full_flipped, 0);
+
+            Mat image0 = image_full_flipped(Rect(0, 0, WIDTH_LARGE, HEIGHT_LARGE));
             surface_computer.init(image0);
+        }
 
         ++step_count;
-        return false;
+        return;
     }
 
     exposure_set = true;
@@ -443,93 +728,24 @@ bool compute()
         // return false;
     }
 
-    algo_name_vec_old = algo_name_vec;
-    algo_name_vec.clear();
+    MotionStageItem item;
+    item.exposure_epoch = exposure_epoch;
+    item.normalized = normalized;
 
-    static bool motion_processor_proceed = false;
-    static bool construct_background = false;
-    static bool first_pass = true;
+    preprocessor_slot->in_use = true;
+    item.preprocessor_slot = preprocessor_slot;
 
-    bool proceed0;
-    bool proceed1;
+    item.y_reflection = surface_computer.y_reflection;
+    item.pitch = imu.pitch;
 
-    if (normalized)
-    {
-        proceed0 = motion_processor0.compute(image_preprocessed0,  image_small0, surface_computer.y_reflection, imu.pitch,
-                                             construct_background, "0",          true);
-        proceed1 = motion_processor1.compute(image_preprocessed1,  image_small1, surface_computer.y_reflection, imu.pitch,
-                                             construct_background, "1",          false);
-    }
-
-    if (first_pass && motion_processor0.both_moving && motion_processor1.both_moving)
-    {
-        console_log("readjusting exposure");
-
-        first_pass = false;
-        exposure_set = false;
-        mat_functions_low_pass_filter.reset();
-
-        CameraInitializerNew::adjust_exposure(camera, image_preprocessed0, true);
-    }
-    else if (!first_pass)
-        construct_background = true;
-
-    if (!construct_background)
-    {
-        proceed0 = false;
-        proceed1 = false;            
-    }
-
-    if (proceed0 && proceed1)
-        motion_processor_proceed = true;
-
-    bool proceed = motion_processor_proceed;
-
-    static bool menu_plus_signal0 = false;
-    if (!menu_plus_signal0)
-    {
-        menu_plus_signal0 = true;
-        // ipc->send_message("menu_plus", "hide window", "");
-    }
-
-    if (proceed)
-    {
-        proceed0 = foreground_extractor0.compute(image_preprocessed0, motion_processor0, "0", true);
-        proceed1 = foreground_extractor1.compute(image_preprocessed1, motion_processor1, "1", false);
-        proceed = proceed0 && proceed1;
-    }
-
-    if (proceed)
-    {
-        proceed0 = hand_splitter0.compute(foreground_extractor0, motion_processor0, "0", false);
-        proceed1 = hand_splitter1.compute(foreground_extractor1, motion_processor1, "1", false);
-        proceed = proceed0 && proceed1;
-    }
-
-    if (proceed)
-    {
-        waiting_for_image = true;
-        waiting_for_image_set = true;
-
-        proceed1 = scopa1.compute_mono0(hand_splitter1, pose_estimator, "1", false);
-        proceed0 = scopa0.compute_mono0(hand_splitter0, pose_estimator, "0", false);
-        proceed = proceed0 && proceed1;
-    }
-
-    if (proceed)
-    {
-        motion_processor0.target_frame = 10;
-        motion_processor1.target_frame = 10;
-
-        SCOPA::compute_stereo();
-        scopa1.compute_mono1("1");
-        scopa0.compute_mono1("0");
-    }
+    ++pipeline_pending;
+    motion_stage_queue.push(move(item));
 
     if (enable_imshow)
+    {
+        show_posted_images();
         waitKey(1);
-
-    return waiting_for_image_set;
+    }
 }
 
 void on_key_down(int code)
@@ -686,9 +902,72 @@ void ipc_thread_function()
 
 #include "math_plus.h"
 
-int main()
+int run_replay(const string session_path, bool realtime)
+{
+    headless = true;
+    enable_imshow = false;
+    settings.touch_control = "1";
+
+    session_player = new SessionPlayer(session_path, realtime);
+    session_player->consumer_ready = []
+    {
+        return Camera::frame_mailbox.empty();
+    };
+    camera = new Camera(session_player, update);
+    start_pipeline();
+
+    const chrono::steady_clock::time_point time_start = chrono::steady_clock::now();
+
+    while (true)
+    {
+        MJPEGFrame* frame = Camera::frame_mailbox.take(100);
+        if (frame == NULL)
+        {
+            if (session_player->finished() && Camera::frame_mailbox.empty())
+                break;
+
+            continue;
+        }
+
+        compute(*frame);
+        Camera::frame_pool.release(frame);
+    }
+
+    while (pipeline_pending > 0)
+        this_thread::sleep_for(chrono::milliseconds(1));
+
+    stop_pipeline();
+
+    const long long time_elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - time_start).count();
+    console_log("replay finished: " + to_string(frame_count) + " frames in " + to_string(time_elapsed) + " ms");
+
+    delete camera;
+    return 0;
+}
+
+int main(int argc, char* argv[])
 {
     init_paths();
+    console_log("simd kernels: " + get_simd_level_name(simd_kernels.level));
+
+    string record_path = "";
+    string replay_path = "";
+    bool replay_realtime = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const string arg = argv[i];
+
+        if (arg == "--record" && i + 1 < argc)
+            record_path = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc)
+            replay_path = argv[++i];
+        else if (arg == "--realtime")
+            replay_realtime = true;
+    }
+
+    if (replay_path != "")
+        return run_replay(replay_path, replay_realtime);
 
     ipc = new IPC("track_plus");
     console_log_ipc = ipc;
@@ -725,9 +1004,17 @@ int main()
     thread guardian_thread(guardian_thread_function);
     thread input_thread(input_thread_function);
 
+    if (record_path != "")
+    {
+        session_recorder = new SessionRecorder();
+        if (session_recorder->open(record_path))
+            Camera::session_recorder = session_recorder;
+    }
+
     camera = new Camera(true, 1280, 480, update);
     
     load_settings();
+    start_pipeline();
 
     while (true)
     {
@@ -737,16 +1024,12 @@ int main()
 
         enable_imshow_old = enable_imshow;
 
-        if (!updated)
-        {
-            Sleep(1);
+        MJPEGFrame* frame = Camera::frame_mailbox.take(100);
+        if (frame == NULL)
             continue;
-        }
-
-        if (!compute())
-            waiting_for_image = true;
 
-        Sleep(1);
+        compute(*frame);
+        Camera::frame_pool.release(frame);
     }
         
     return 0;
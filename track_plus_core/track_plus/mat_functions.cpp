@@ -22,6 +22,9 @@
 LowPassFilter mat_functions_low_pass_filter;
 ValueStore mat_functions_value_store;
 
+mutex posted_images_mutex;
+vector<pair<string, Mat>> posted_images;
+
 void threshold_get_bounds(Mat& image_in, Mat& image_out, const int threshold_val, int& x_min, int& x_max, int& y_min, int& y_max)
 {
 	Mat image_out_temp = Mat::zeros(image_in.size(), CV_8UC1);
@@ -34,21 +37,33 @@ void threshold_get_bounds(Mat& image_in, Mat& image_out, const int threshold_val
 	y_min = 9999;
 	y_max = 0;
 
-	for (int i = 0; i < i_max; ++i)
+	if (threshold_val < 0)
+	{
+		image_out_temp = Scalar(254);
+		x_max = i_max - 1;
+		y_max = j_max - 1;
+
+		if (i_max > 0 && j_max > 0)
+			x_min = y_min = 0;
+	}
+	else if (threshold_val < 255)
 		for (int j = 0; j < j_max; ++j)
-			if (image_in.ptr<uchar>(j, i)[0] > threshold_val)
-			{
-				image_out_temp.ptr<uchar>(j, i)[0] = 254;
-
-				if (i < x_min)
-					x_min = i;
-				if (i > x_max)
-					x_max = i;
-				if (j < y_min)
-					y_min = j;
-				if (j > y_max)
-					y_max = j;
-			}
+		{
+			int i_min_row;
+			int i_max_row;
+			simd_kernels.threshold_row(image_in.ptr<uchar>(j), image_out_temp.ptr<uchar>(j), i_max, threshold_val, 254, i_min_row, i_max_row);
+
+			if (i_min_row == -1)
+				continue;
+
+			if (i_min_row < x_min)
+				x_min = i_min_row;
+			if (i_max_row > x_max)
+				x_max = i_max_row;
+			if (j < y_min)
+				y_min = j;
+			y_max = j;
+		}
 
 	if (x_min == 9999)
 		x_min = x_max = y_min = y_max = 0;
@@ -71,23 +86,18 @@ Mat translate_image(Mat& image_in, const int x_diff, const int y_diff)
 {
 	const int width_const = image_in.cols;
 	const int height_const = image_in.rows;
-	const int width_const_minus = width_const - 1;
-	const int height_const_minus = height_const - 1;
 
 	Mat image_result = Mat::zeros(height_const, width_const, CV_8UC1);
 
-	for (int i = 0; i < width_const; ++i)
-		for (int j = 0; j < height_const; ++j)
-			if (image_in.ptr<uchar>(j, i)[0] > 0)
-			{
-				const int i_new = i + x_diff;
-				const int j_new = j + y_diff;
-
-				if (i_new < 0 || i_new > width_const_minus || j_new < 0 || j_new > height_const_minus)
-					continue;
+	//a shift maps pixels one to one, so copying the overlapping rows equals copying every nonzero pixel
+	const int i_begin = max(0, -x_diff);
+	const int i_end = min(width_const, width_const - x_diff);
+	const int j_begin = max(0, -y_diff);
+	const int j_end = min(height_const, height_const - y_diff);
 
-				image_result.ptr<uchar>(j_new, i_new)[0] = image_in.ptr<uchar>(j, i)[0];
-			}
+	if (i_begin < i_end)
+		for (int j = j_begin; j < j_end; ++j)
+			memcpy(image_result.ptr<uchar>(j + y_diff) + i_begin + x_diff, image_in.ptr<uchar>(j) + i_begin, i_end - i_begin);
 
 	return image_result;
 }
@@ -102,154 +112,238 @@ Mat resize_image(Mat& image_in, const float scale)
 	const int x_offset = (image_new.cols - image_resized.cols) / 2;
 	const int y_offset = (image_new.rows - image_resized.rows) / 2;
 
-	const int i_max = image_resized.cols;
-	const int j_max = image_resized.rows;
-	for (int i = 0; i < i_max; ++i)
-	{
-		const int i_new = i + x_offset;
-		if (i_new >= image_in.cols || i_new < 0)
-			continue;
+	const int i_begin = max(0, -x_offset);
+	const int i_end = min(image_resized.cols, image_in.cols - x_offset);
+	const int j_begin = max(0, -y_offset);
+	const int j_end = min(image_resized.rows, image_in.rows - y_offset);
 
-		for (int j = 0; j < j_max; ++j)
-		{
-			const int j_new = j + y_offset;
-			if (j_new >= image_in.rows || j_new < 0)
-				continue;
-
-			image_new.ptr<uchar>(j_new, i_new)[0] = image_resized.ptr<uchar>(j, i)[0];
-		}
-	}
+	if (i_begin < i_end)
+		for (int j = j_begin; j < j_end; ++j)
+			memcpy(image_new.ptr<uchar>(j + y_offset) + i_begin + x_offset, image_resized.ptr<uchar>(j) + i_begin, i_end - i_begin);
 
 	return image_new;
 }
 
-void distance_transform(Mat& image_in, float& dist_min, float& dist_max, Point& pt_dist_min, Point& pt_dist_max, bool accurate)
+void distance_transform(Mat& image_in, Mat& image_out, float& dist_min, float& dist_max, Point& pt_dist_min, Point& pt_dist_max)
 {
-	Mat image_find_contours = image_in.clone();
+	const int image_width_const = image_in.cols;
+	const int image_height_const = image_in.rows;
 
-	// vector<Vec4i> hiearchy;
-	// vector<vector<Point>> contours;
-	// findContours(image_find_contours, contours, hiearchy, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE, Point(0, 0));
-	vector<vector<Point>> contours = legacyFindContours(image_find_contours);
+	image_out.create(image_height_const, image_width_const, CV_32FC1);
 
 	dist_min = 9999;
 	dist_max = 0;
+	pt_dist_min = Point(0, 0);
+	pt_dist_max = Point(0, 0);
 
-	const int image_width_const = image_in.cols;
-	const int image_height_const = image_in.rows;
+	if (image_width_const == 0 || image_height_const == 0)
+		return;
 
-	for (int i = 0; i < image_width_const; ++i)
-		for (int j = 0; j < image_height_const; ++j)
-			if (image_in.ptr<uchar>(j, i)[0] > 0)
-			{
-				float dist_min_current = 9999;
-				for (vector<Point>& contour : contours)
-					for (Point& pt : contour)
-					{
-						const float dist_current = get_distance(i, j, pt.x, pt.y, accurate);
-						if (dist_current < dist_min_current)
-							dist_min_current = dist_current;
-					}
-
-				if (dist_min_current < dist_min)
-				{
-					dist_min = dist_min_current;
-					pt_dist_min = Point(i, j);
-				}
-
-				if (dist_min_current > dist_max)
-				{
-					dist_max = dist_min_current;
-					pt_dist_max = Point(i, j);
-				}
-			}
-}
+	//pixels with no zero pixel in their column, kept finite so that the envelope below does not run into inf - inf
+	const float dist_none = 1e20;
 
-bool compute_channel_diff_image(Mat& image_in, Mat& image_out, bool normalize, string name, bool set_norm_range, bool low_pass)
-{
-	bool result = true;
+	//vertical distance to the nearest zero pixel, down and then up every column
+	for (int j = 0; j < image_height_const; ++j)
+	{
+		const uchar* row = image_in.ptr<uchar>(j);
+		float* row_out = image_out.ptr<float>(j);
+		const float* row_out_above = j > 0 ? image_out.ptr<float>(j - 1) : NULL;
 
-	static string channel_diff_image_primary_name = "";
-	if (channel_diff_image_primary_name == "")
-		channel_diff_image_primary_name = name;
+		for (int i = 0; i < image_width_const; ++i)
+			row_out[i] = row[i] == 0 ? 0 : (row_out_above != NULL ? row_out_above[i] + 1 : dist_none);
+	}
 
-	const int image_width_const = image_in.cols;
-	const int image_height_const = image_in.rows;
+	for (int j = image_height_const - 2; j >= 0; --j)
+	{
+		float* row_out = image_out.ptr<float>(j);
+		const float* row_out_below = image_out.ptr<float>(j + 1);
 
-	image_out = Mat(image_height_const, image_width_const, CV_8UC1);
+		for (int i = 0; i < image_width_const; ++i)
+			if (row_out_below[i] + 1 < row_out[i])
+				row_out[i] = row_out_below[i] + 1;
+	}
 
-	static uchar gray_min;
-	static uchar gray_max;
-	static bool do_normalize = false;
+	//lower envelope of the parabolas (x - i)^2 + column distance^2 along every row, Felzenszwalb and Huttenlocher
+	vector<float> f(image_width_const);
+	vector<int> v(image_width_const);
+	vector<float> z(image_width_const + 1);
 
-	if (name == channel_diff_image_primary_name && set_norm_range)
+	for (int j = 0; j < image_height_const; ++j)
 	{
-		vector<uchar> gray_vec;
+		const uchar* row = image_in.ptr<uchar>(j);
+		float* row_out = image_out.ptr<float>(j);
+
 		for (int i = 0; i < image_width_const; ++i)
-			for (int j = 0; j < image_height_const; ++j)
+			f[i] = row_out[i] >= dist_none ? dist_none : row_out[i] * row_out[i];
+
+		int k = 0;
+		v[0] = 0;
+		z[0] = -dist_none;
+		z[1] = dist_none;
+
+		for (int i = 1; i < image_width_const; ++i)
+		{
+			float s = ((f[i] + i * i) - (f[v[k]] + v[k] * v[k])) / (2 * i - 2 * v[k]);
+			while (s <= z[k])
 			{
-				int diff0 = image_in.ptr<uchar>(j, i)[0] - image_in.ptr<uchar>(j, i)[1];
-				int diff1 = image_in.ptr<uchar>(j, i)[2] - image_in.ptr<uchar>(j, i)[1];
+				--k;
+				s = ((f[i] + i * i) - (f[v[k]] + v[k] * v[k])) / (2 * i - 2 * v[k]);
+			}
 
-				if (diff0 < 0)
-					diff0 = 0;
-				if (diff1 < 0)
-					diff1 = 0;
+			++k;
+			v[k] = i;
+			z[k] = s;
+			z[k + 1] = dist_none;
+		}
+
+		//the min and max over the foreground come out of the same pass, first in raster order on a tie like minMaxLoc
+		k = 0;
+		for (int i = 0; i < image_width_const; ++i)
+		{
+			while (z[k + 1] < i)
+				++k;
 
-				const uchar gray = min(diff0, diff1);
-				gray_vec.push_back(gray);
-				image_out.ptr<uchar>(j, i)[0] = gray;
+			const float dist_current = sqrt((i - v[k]) * (i - v[k]) + f[v[k]]);
+			row_out[i] = dist_current;
+
+			if (row[i] == 0)
+				continue;
+
+			if (dist_current < dist_min)
+			{
+				dist_min = dist_current;
+				pt_dist_min = Point(i, j);
 			}
 
-		sort(gray_vec.begin(), gray_vec.end());
-		uchar gray_min_new = gray_vec[0];
-		uchar gray_max_new = gray_vec[gray_vec.size() - 1];
+			if (dist_current > dist_max)
+			{
+				dist_max = dist_current;
+				pt_dist_max = Point(i, j);
+			}
+		}
+	}
+}
+
+bool compute_channel_diff_image(Mat& image_in, Mat& image_out, bool normalize, bool set_norm_range, bool low_pass)
+{
+	const int image_width_const = image_in.cols;
+	const int image_height_const = image_in.rows;
+
+	image_out = Mat(image_height_const, image_width_const, CV_8UC1);
+
+	for (int j = 0; j < image_height_const; ++j)
+		channel_diff_row(image_in.ptr<uchar>(j), image_out.ptr<uchar>(j), image_width_const);
 
-		if (low_pass)
+	return normalize_channel_diff_image(image_out, normalize, set_norm_range, low_pass);
+}
+
+//B - G and R - G do not depend on Y, so min(B - G, R - G) is a function of Cb and Cr alone
+void build_channel_diff_lut(uchar* lut)
+{
+	//JFIF full range as decoded from the MJPEG stream
+	const float cb_b = 2.116136;
+	const float cr_b = 0.714136;
+	const float cb_r = 0.344136;
+	const float cr_r = 2.116136;
+
+	for (int cb = 0; cb < 256; ++cb)
+		for (int cr = 0; cr < 256; ++cr)
 		{
-			mat_functions_low_pass_filter.compute(gray_min_new, 0.1, "gray_min_new");
-			mat_functions_low_pass_filter.compute(gray_max_new, 0.1, "gray_max_new");
+			int diff0 = roundf(cb_b * (cb - 128) + cr_b * (cr - 128));
+			int diff1 = roundf(cb_r * (cb - 128) + cr_r * (cr - 128));
+
+			if (diff0 < 0)
+				diff0 = 0;
+			if (diff1 < 0)
+				diff1 = 0;
+
+			int gray = min(diff0, diff1);
+			if (gray > 255)
+				gray = 255;
+
+			lut[(cb << 8) + cr] = gray;
 		}
+}
 
-		if (abs(gray_min_new - gray_min) + abs(gray_max_new - gray_max) > 2)
-			result = false;
+const uchar* get_channel_diff_lut()
+{
+	static uchar lut[256 * 256];
+	static bool lut_built = false;
 
-		gray_min = gray_min_new;
-		gray_max = gray_max_new;
-		do_normalize = true;
+	if (!lut_built)
+	{
+		build_channel_diff_lut(lut);
+		lut_built = true;
 	}
-	else
+
+	return lut;
+}
+
+uchar channel_diff_gray_min;
+uchar channel_diff_gray_max;
+bool channel_diff_range_set = false;
+
+bool set_channel_diff_range(uchar gray_min_new, uchar gray_max_new, bool low_pass)
+{
+	bool result = true;
+
+	if (low_pass)
 	{
-		for (int i = 0; i < image_width_const; ++i)
-			for (int j = 0; j < image_height_const; ++j)
-			{
-				int diff0 = image_in.ptr<uchar>(j, i)[0] - image_in.ptr<uchar>(j, i)[1];
-				int diff1 = image_in.ptr<uchar>(j, i)[2] - image_in.ptr<uchar>(j, i)[1];
+		mat_functions_low_pass_filter.compute(gray_min_new, 0.1, "gray_min_new");
+		mat_functions_low_pass_filter.compute(gray_max_new, 0.1, "gray_max_new");
+	}
 
-				if (diff0 < 0)
-					diff0 = 0;
-				if (diff1 < 0)
-					diff1 = 0;
+	if (abs(gray_min_new - channel_diff_gray_min) + abs(gray_max_new - channel_diff_gray_max) > 2)
+		result = false;
 
-				const uchar gray = min(diff0, diff1);
-				image_out.ptr<uchar>(j, i)[0] = gray;
-			}
+	channel_diff_gray_min = gray_min_new;
+	channel_diff_gray_max = gray_max_new;
+	channel_diff_range_set = true;
+
+	return result;
+}
+
+bool build_channel_diff_normalize_lut(uchar* lut)
+{
+	if (!channel_diff_range_set)
+		return false;
+
+	for (int val = 0; val < 256; ++val)
+	{
+		int gray = map_val(val, channel_diff_gray_min, channel_diff_gray_max, 0, 254);
+		if (gray > 254)
+			gray = 254;
+		if (gray < 0)
+			gray = 0;
+
+		lut[val] = gray;
 	}
+	return true;
+}
 
-	if (normalize && do_normalize)
-		for (int i = 0; i < image_width_const; ++i)
-			for (int j = 0; j < image_height_const; ++j)
-			{
-				int gray = map_val(image_out.ptr<uchar>(j, i)[0], gray_min, gray_max, 0, 254);
-				if (gray > 254)
-					gray = 254;
-				if (gray < 0)
-					gray = 0;
+bool normalize_channel_diff_image(Mat& image_out, bool normalize, bool set_norm_range, bool low_pass)
+{
+	bool result = true;
 
-				image_out.ptr<uchar>(j, i)[0] = gray;
-			}
+	const int image_width_const = image_out.cols;
+	const int image_height_const = image_out.rows;
+
+	if (set_norm_range)
+	{
+		uchar gray_min_new = 255;
+		uchar gray_max_new = 0;
+		for (int j = 0; j < image_height_const; ++j)
+			min_max_row(image_out.ptr<uchar>(j), image_width_const, gray_min_new, gray_max_new);
+
+		result = set_channel_diff_range(gray_min_new, gray_max_new, low_pass);
+	}
+
+	uchar lut_normalize[256];
+	if (normalize && build_channel_diff_normalize_lut(lut_normalize))
+		for (int j = 0; j < image_height_const; ++j)
+			lut_row(image_out.ptr<uchar>(j), image_width_const, lut_normalize);
 
-	rectangle(image_out, Rect(0, 0, image_in.cols, image_in.rows), Scalar(0), 2);
+	rectangle(image_out, Rect(0, 0, image_width_const, image_height_const), Scalar(0), 2);
 	return result;
 }
 
@@ -258,10 +352,8 @@ void compute_max_image(Mat& image_in, Mat& image_out)
 	const int image_width_const = image_in.cols;
 	const int image_height_const = image_in.rows;
 
-	for (int i = 0; i < image_width_const; ++i)
-		for (int j = 0; j < image_height_const; ++j)
-			image_out.ptr<uchar>(j, i)[0] = max(image_in.ptr<uchar>(j, i)[0],
-										    max(image_in.ptr<uchar>(j, i)[1], image_in.ptr<uchar>(j, i)[2]));
+	for (int j = 0; j < image_height_const; ++j)
+		simd_kernels.max_channel_row(image_in.ptr<uchar>(j), image_out.ptr<uchar>(j), image_width_const);
 }
 
 void compute_active_light_image(Mat& image_regular, Mat& image_channel_diff, Mat& image_out)
@@ -270,20 +362,8 @@ void compute_active_light_image(Mat& image_regular, Mat& image_channel_diff, Mat
 	const int image_height_const = image_regular.rows;
 
 	image_out = Mat(image_height_const, image_width_const, CV_8UC1);
-	for (int i = 0; i < image_width_const; ++i)
-		for (int j = 0; j < image_height_const; ++j)
-		{
-			const uchar gray0 = (image_regular.ptr<uchar>(j, i)[0] +
-								 image_regular.ptr<uchar>(j, i)[1] +
-								 image_regular.ptr<uchar>(j, i)[2]) / 3;
-
-			const uchar gray1 = image_channel_diff.ptr<uchar>(j, i)[0];
-			int gray_subtraction = abs(gray0 - gray1);
-			if (gray_subtraction == 255)
-				gray_subtraction = 254;
-
-			image_out.ptr<uchar>(j, i)[0] = gray_subtraction;
-		}
+	for (int j = 0; j < image_height_const; ++j)
+		simd_kernels.active_light_row(image_regular.ptr<uchar>(j), image_channel_diff.ptr<uchar>(j), image_out.ptr<uchar>(j), image_width_const);
 }
 
 void compute_color_segmented_image(Mat& image_in, Mat& image_out)
@@ -333,17 +413,8 @@ void compute_motion_structure_image(Mat& image_in, Mat& image_out, string name)
 	Mat image_old = mat_functions_value_store.get_mat("image_motion_structure" + name, true);
 
 	Mat image_subtraction = Mat(HEIGHT_SMALL, WIDTH_SMALL, CV_8UC1);
-	for (int i = 0; i < WIDTH_SMALL; ++i)
-		for (int j = 0; j < HEIGHT_SMALL; ++j)
-		{
-			int diff = image_in.ptr<uchar>(j, i)[0] - image_old.ptr<uchar>(j, i)[0] + 127;
-			if (diff < 0)
-				diff = 0;
-			else if (diff > 254)
-				diff = 254;
-
-			image_subtraction.ptr<uchar>(j, i)[0] = diff;
-		}
+	for (int j = 0; j < HEIGHT_SMALL; ++j)
+		simd_kernels.motion_structure_row(image_in.ptr<uchar>(j), image_old.ptr<uchar>(j), image_subtraction.ptr<uchar>(j), WIDTH_SMALL);
 	equalizeHist(image_subtraction, image_subtraction);
 
 	mat_functions_value_store.set_mat("image_motion_structure" + name, image_in);
@@ -400,11 +471,43 @@ void fill_mat(Mat& image, vector<Point>& pt_vec, uchar gray)
 	const int i_max = image.cols;
 	const int j_max = image.rows;
 
+	//scattered writes, nothing to vectorize, the unsigned compares fold both bounds checks
 	for (Point& pt : pt_vec)
 	{
-		if (pt.x < 0 || pt.y < 0 || pt.x >= i_max || pt.y >= j_max)
+		if ((unsigned int)pt.x >= (unsigned int)i_max || (unsigned int)pt.y >= (unsigned int)j_max)
 			continue;
 
-		image.ptr<uchar>(pt.y, pt.x)[0] = gray;
-	}			
+		image.ptr<uchar>(pt.y)[pt.x] = gray;
+	}
+}
+
+void post_imshow(const string name, const Mat& image)
+{
+	if (!enable_imshow)
+		return;
+
+	//the stage keeps drawing into its buffers after posting
+	Mat image_copy = image.clone();
+
+	lock_guard<mutex> lock(posted_images_mutex);
+	for (pair<string, Mat>& posted_image : posted_images)
+		if (posted_image.first == name)
+		{
+			posted_image.second = image_copy;
+			return;
+		}
+
+	posted_images.push_back(make_pair(name, image_copy));
+}
+
+void show_posted_images()
+{
+	vector<pair<string, Mat>> posted_images_current;
+	{
+		lock_guard<mutex> lock(posted_images_mutex);
+		posted_images_current.swap(posted_images);
+	}
+
+	for (pair<string, Mat>& posted_image : posted_images_current)
+		imshow(posted_image.first, posted_image.second);
 }
\ No newline at end of file
@@ -24,6 +24,7 @@
 #include "low_pass_filter.h"
 #include "contour_functions.h"
 #include "value_store.h"
+#include "simd_functions.h"
 
 using namespace cv;
 
@@ -33,10 +34,17 @@ void threshold_get_bounds(Mat& image_in, Mat& image_out, const int threshold_val
 Mat rotate_image(const Mat& image_in, const float angle, const Point origin, const int border);
 Mat translate_image(Mat& image_in, const int x_diff, const int y_diff);
 Mat resize_image(Mat& image_in, const float scale);
-void distance_transform(Mat& image_in, float& dist_min, float& dist_max, Point& pt_dist_min, Point& pt_dist_max, bool accurate);
+//exact euclidean distance of every pixel to the nearest zero pixel as CV_32FC1, what distanceTransform gives with CV_DIST_L2
+//and CV_DIST_MASK_PRECISE, along with the smallest and largest distance over the nonzero pixels and where they are
+void distance_transform(Mat& image_in, Mat& image_out, float& dist_min, float& dist_max, Point& pt_dist_min, Point& pt_dist_max);
 
-bool compute_channel_diff_image(Mat& image_in, Mat& image_out, bool normalize, string name,
-							    bool set_norm_range = false, bool low_pass = false);
+bool compute_channel_diff_image(Mat& image_in, Mat& image_out, bool normalize, bool set_norm_range = false, bool low_pass = false);
+bool normalize_channel_diff_image(Mat& image_out, bool normalize, bool set_norm_range, bool low_pass);
+//Cb, Cr indexed table shared by every YUV channel diff computation
+const uchar* get_channel_diff_lut();
+//range of the primary channel diff image (the one computed with set_norm_range), every later normalization maps it to 0..254
+bool set_channel_diff_range(uchar gray_min_new, uchar gray_max_new, bool low_pass);
+bool build_channel_diff_normalize_lut(uchar* lut);
 
 void compute_max_image(Mat& image_in, Mat& image_out);
 void compute_active_light_image(Mat& image_regular, Mat& image_channel_diff, Mat& image_out);
@@ -45,4 +53,8 @@ void compute_motion_structure_image(Mat& image_in, Mat& image_out, string name);
 void print_mat_type(Mat& image_in);
 void put_text(string text, Mat& img, int x, int y);
 void put_text(string text, Mat& img, Point pt);
-void fill_mat(Mat& image, vector<Point>& pt_vec, uchar gray);
\ No newline at end of file
+void fill_mat(Mat& image, vector<Point>& pt_vec, uchar gray);
+//HighGUI windows belong to the main thread, the pipeline stages post a copy of what they want shown here
+void post_imshow(const string name, const Mat& image);
+//shows the latest image posted under each name, main thread only
+void show_posted_images();
\ No newline at end of file
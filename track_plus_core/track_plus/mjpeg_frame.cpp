@@ -0,0 +1,248 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "mjpeg_frame.h"
+
+MJPEGFrame::MJPEGFrame(int _width, int _height)
+{
+	width = _width;
+	height = _height;
+	ref_count = 0;
+
+	image_small_frame = Mat(height / MJPEG_SCALE_DENOM_SMALL, width / MJPEG_SCALE_DENOM_SMALL, CV_8UC3);
+	image_y_small_frame = Mat(height / MJPEG_SCALE_DENOM_SMALL, width / MJPEG_SCALE_DENOM_SMALL, CV_8UC1);
+
+	const int width_side = image_small_frame.cols / 2;
+	for (int side = 0; side < 2; ++side)
+	{
+		Rect rect_side = Rect(side * width_side, 0, width_side, image_small_frame.rows);
+		image_small[side] = image_small_frame(rect_side);
+		image_y_small[side] = image_y_small_frame(rect_side);
+	}
+
+	image_full = Mat(height, width, CV_8UC3);
+	image_thumbnail = Mat(height / MJPEG_SCALE_DENOM_THUMBNAIL, width / MJPEG_SCALE_DENOM_THUMBNAIL, CV_8UC1);
+}
+
+void MJPEGFrame::set(unsigned char* _data, unsigned long _size)
+{
+	if (data.size() < _size)
+		data.resize(_size);
+
+	memcpy(&data[0], _data, _size);
+	size = _size;
+
+	small_decoded = false;
+	full_decoded = false;
+	thumbnail_decoded = false;
+	planes_decoded = false;
+
+	roi_rect_vec.clear();
+	roi_image_vec.clear();
+}
+
+bool MJPEGFrame::decode_small()
+{
+	if (!small_decoded && size > 0)
+		small_decoded = jpeg_decompressor.compute(&data[0], size, image_small_frame.data,
+												  image_small_frame.cols, image_small_frame.rows);
+
+	return small_decoded;
+}
+
+bool MJPEGFrame::decode_full()
+{
+	if (!full_decoded && size > 0)
+		full_decoded = jpeg_decompressor.compute(&data[0], size, image_full.data, image_full.cols, image_full.rows);
+
+	return full_decoded;
+}
+
+bool MJPEGFrame::decode_thumbnail()
+{
+	if (!thumbnail_decoded && size > 0)
+		thumbnail_decoded = jpeg_decompressor.compute(&data[0], size, image_thumbnail.data,
+													  image_thumbnail.cols, image_thumbnail.rows, TJPF_GRAY);
+
+	return thumbnail_decoded;
+}
+
+bool MJPEGFrame::decode_planes()
+{
+	if (!planes_decoded && size > 0)
+		planes_decoded = decode_small_planes();
+
+	return planes_decoded;
+}
+
+bool MJPEGFrame::decode_small_planes()
+{
+	if (subsampling == -1)
+		if (!jpeg_decompressor.get_subsampling(&data[0], size, subsampling))
+			return false;
+
+	const int width_small = image_y_small_frame.cols;
+	const int height_small = image_y_small_frame.rows;
+	const int width_chroma = tjPlaneWidth(1, width_small, subsampling);
+	const int height_chroma = tjPlaneHeight(1, height_small, subsampling);
+
+	if (width_chroma <= 0 || height_chroma <= 0)
+		return false;
+
+	if (image_cb_plane_frame.cols != width_chroma || image_cb_plane_frame.rows != height_chroma)
+	{
+		image_cb_plane_frame = Mat(height_chroma, width_chroma, CV_8UC1);
+		image_cr_plane_frame = Mat(height_chroma, width_chroma, CV_8UC1);
+	}
+
+	unsigned char* planes[3] = { image_y_small_frame.data, image_cb_plane_frame.data, image_cr_plane_frame.data };
+	int strides[3] = { width_small, width_chroma, width_chroma };
+
+	if (!jpeg_decompressor.compute_planes(&data[0], size, planes, strides, width_small, height_small))
+		return false;
+
+	if (width_chroma == width_small && height_chroma == height_small)
+	{
+		image_cb_small[0] = image_cb_plane_frame(Rect(0, 0, width_small / 2, height_small));
+		image_cb_small[1] = image_cb_plane_frame(Rect(width_small / 2, 0, width_small / 2, height_small));
+		image_cr_small[0] = image_cr_plane_frame(Rect(0, 0, width_small / 2, height_small));
+		image_cr_small[1] = image_cr_plane_frame(Rect(width_small / 2, 0, width_small / 2, height_small));
+		return true;
+	}
+
+	//each side is upsampled from its own half so that no chroma bleeds across the seam between the cameras
+	const int width_chroma_side = width_chroma / 2;
+	for (int side = 0; side < 2; ++side)
+	{
+		Rect rect_chroma = Rect(side * width_chroma_side, 0, width_chroma_side, height_chroma);
+		resize(image_cb_plane_frame(rect_chroma), image_cb_small[side], image_y_small[side].size(), 0, 0, INTER_LINEAR);
+		resize(image_cr_plane_frame(rect_chroma), image_cr_small[side], image_y_small[side].size(), 0, 0, INTER_LINEAR);
+	}
+
+	return true;
+}
+
+Mat& MJPEGFrame::get_small(const uchar side)
+{
+	decode_small();
+	return image_small[side];
+}
+
+Mat& MJPEGFrame::get_full()
+{
+	decode_full();
+	return image_full;
+}
+
+Rect MJPEGFrame::to_coded_rect(Rect rect, const uchar side)
+{
+	return Rect(rect.x + side * (width / 2), height - rect.y - rect.height, rect.width, rect.height);
+}
+
+bool MJPEGFrame::decode_rois(vector<Rect>& rect_coded_vec)
+{
+	if (full_decoded || size == 0)
+		return full_decoded;
+
+	if (subsampling == -1)
+		if (!jpeg_decompressor.get_subsampling(&data[0], size, subsampling))
+			return false;
+
+	const int mcu_width = tjMCUWidth[subsampling];
+	const int mcu_height = tjMCUHeight[subsampling];
+
+	vector<tjregion> regions;
+	vector<Rect> rect_aligned_vec;
+
+	for (Rect& rect_coded : rect_coded_vec)
+	{
+		bool cached = false;
+		for (Rect& rect_cached : roi_rect_vec)
+			if ((rect_coded & rect_cached) == rect_coded)
+			{
+				cached = true;
+				break;
+			}
+
+		if (cached)
+			continue;
+
+		const int x0 = (rect_coded.x / mcu_width) * mcu_width;
+		const int y0 = (rect_coded.y / mcu_height) * mcu_height;
+		const int x1 = min(((rect_coded.x + rect_coded.width + mcu_width - 1) / mcu_width) * mcu_width, width);
+		const int y1 = min(((rect_coded.y + rect_coded.height + mcu_height - 1) / mcu_height) * mcu_height, height);
+
+		tjregion region;
+		region.x = x0;
+		region.y = y0;
+		region.w = x1 - x0;
+		region.h = y1 - y0;
+
+		regions.push_back(region);
+		rect_aligned_vec.push_back(Rect(x0, y0, x1 - x0, y1 - y0));
+	}
+
+	if (regions.size() == 0)
+		return true;
+
+	vector<Mat> image_vec;
+	vector<unsigned char*> outs;
+	for (Rect& rect_aligned : rect_aligned_vec)
+	{
+		image_vec.push_back(Mat(rect_aligned.height, rect_aligned.width, CV_8UC3));
+		outs.push_back(image_vec.back().data);
+	}
+
+	if (!jpeg_decompressor.compute_crop(&data[0], size, regions, outs))
+		return false;
+
+	for (int i = 0; i < (int)rect_aligned_vec.size(); ++i)
+	{
+		roi_rect_vec.push_back(rect_aligned_vec[i]);
+		roi_image_vec.push_back(image_vec[i]);
+	}
+
+	return true;
+}
+
+Mat MJPEGFrame::get_roi(Rect rect, const uchar side)
+{
+	Mat image_roi;
+	Rect rect_coded = to_coded_rect(rect, side);
+
+	if (full_decoded)
+	{
+		flip(image_full(rect_coded), image_roi, 0);
+		return image_roi;
+	}
+
+	vector<Rect> rect_coded_vec;
+	rect_coded_vec.push_back(rect_coded);
+	if (!decode_rois(rect_coded_vec))
+		return image_roi;
+
+	for (int i = 0; i < (int)roi_rect_vec.size(); ++i)
+		if ((rect_coded & roi_rect_vec[i]) == rect_coded)
+		{
+			Rect rect_tile = rect_coded - roi_rect_vec[i].tl();
+			flip(roi_image_vec[i](rect_tile), image_roi, 0);
+			break;
+		}
+
+	return image_roi;
+}
\ No newline at end of file
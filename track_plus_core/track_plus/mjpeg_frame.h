@@ -0,0 +1,95 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <opencv2/opencv.hpp>
+
+#include "jpeg_decompressor.h"
+#include "globals.h"
+
+using namespace std;
+using namespace cv;
+
+#define MJPEG_SCALE_DENOM_SMALL     4
+#define MJPEG_SCALE_DENOM_THUMBNAIL 8
+
+class MJPEGFrame
+{
+public:
+	int width;
+	int height;
+
+	vector<unsigned char> data;
+	unsigned long size = 0;
+	//capture time in microseconds, the recorded one when replaying, same clock as AccelerometerSample::timestamp
+	long long timestamp = 0;
+
+	//the whole frame is decoded once at 1/4 scale straight out of the IDCT, the sides are views into its halves
+	//and not decoded on two threads: both sides are in one huffman coded scan that only a single pass can walk
+	Mat image_small_frame;
+	Mat image_small[2];
+	Mat image_full;
+	//planes of the small images, chroma is upsampled to the luma size of each side on its own
+	Mat image_y_small_frame;
+	Mat image_cb_plane_frame;
+	Mat image_cr_plane_frame;
+	Mat image_y_small[2];
+	Mat image_cb_small[2];
+	Mat image_cr_small[2];
+	//one luma value per 8x8 block, at 1/8 scale libjpeg-turbo reconstructs it from the DC coefficient alone
+	Mat image_thumbnail;
+
+	bool small_decoded = false;
+	bool full_decoded = false;
+	bool thumbnail_decoded = false;
+	bool planes_decoded = false;
+
+	int subsampling = -1;
+
+	//full resolution tiles decoded on demand, in coded (unflipped) coordinates and aligned to MCUs. HandResolver and
+	//PointResolver are the only users and the live pipeline runs neither yet, SCOPA's tips are not refined at full size
+	vector<Rect> roi_rect_vec;
+	vector<Mat> roi_image_vec;
+
+	JPEGDecompressor jpeg_decompressor;
+
+	//owned by FramePool, the frame is free for reuse once this drops to 0
+	atomic<int> ref_count;
+
+	MJPEGFrame(int _width, int _height);
+
+	void set(unsigned char* _data, unsigned long _size);
+	bool decode_small();
+	bool decode_full();
+	bool decode_thumbnail();
+	bool decode_planes();
+	Mat& get_small(const uchar side);
+	Mat& get_full();
+
+	//maps a rect in the flipped per-side coordinates used after compute() splits the frame to coded coordinates
+	Rect to_coded_rect(Rect rect, const uchar side);
+	//decodes all uncached rects in one pass, batch them to avoid entropy decoding the frame more than once
+	bool decode_rois(vector<Rect>& rect_coded_vec);
+	Mat get_roi(Rect rect, const uchar side);
+
+private:
+	bool decode_small_planes();
+};
\ No newline at end of file
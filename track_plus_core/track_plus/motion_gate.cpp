@@ -0,0 +1,99 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "motion_gate.h"
+
+MotionGate::MotionGate()
+{
+	enabled = false;
+}
+
+bool MotionGate::compute(MJPEGFrame& frame)
+{
+	if (!enabled)
+		return true;
+
+	bool proceed = false;
+	if (size_reference == 0 || frames_skipped >= frames_skipped_max)
+		proceed = true;
+	else if (abs((float)frame.size - (float)size_reference) > size_reference * size_ratio_threshold)
+	{
+		proceed = true;
+		thumbnail_reference_valid = false;
+	}
+	else if (!thumbnail_reference_valid)
+	{
+		proceed = true;
+		if (frame.decode_thumbnail())
+		{
+			frame.image_thumbnail.copyTo(image_thumbnail_reference);
+			thumbnail_reference_valid = true;
+			probe_count = 0;
+		}
+	}
+	else if (++probe_count >= probe_interval)
+	{
+		probe_count = 0;
+		proceed = !frame.decode_thumbnail() || compute_thumbnail_changed(frame.image_thumbnail);
+	}
+
+	if (proceed)
+	{
+		size_reference = frame.size;
+		frames_skipped = 0;
+	}
+	else
+		++frames_skipped;
+
+	return proceed;
+}
+
+bool MotionGate::compute_thumbnail_changed(Mat& image_thumbnail)
+{
+	if (image_thumbnail_reference.size() != image_thumbnail.size())
+		return true;
+
+	const int width = image_thumbnail.cols;
+	const int height = image_thumbnail.rows;
+
+	int changed_blocks = 0;
+	for (int j = 0; j < height && changed_blocks < changed_blocks_min; ++j)
+	{
+		uchar* row = image_thumbnail.ptr<uchar>(j);
+		uchar* row_reference = image_thumbnail_reference.ptr<uchar>(j);
+
+		for (int i = 0; i < width; ++i)
+			if (abs(row[i] - row_reference[i]) > diff_threshold)
+				++changed_blocks;
+	}
+
+	if (changed_blocks < changed_blocks_min)
+		return false;
+
+	image_thumbnail.copyTo(image_thumbnail_reference);
+	return true;
+}
+
+void MotionGate::reset()
+{
+	image_thumbnail_reference = Mat();
+	thumbnail_reference_valid = false;
+	size_reference = 0;
+	probe_count = 0;
+	frames_skipped = 0;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <opencv2/opencv.hpp>
+#include "mjpeg_frame.h"
+
+using namespace std;
+using namespace cv;
+
+class MotionGate
+{
+public:
+	//set by the pipeline thread once the background is built, read by the camera thread
+	atomic<bool> enabled;
+
+	//the compressed size follows the content, a frame whose size moved by more than size_ratio_threshold from the last
+	//frame let through has changed and goes through without decoding anything
+	float size_ratio_threshold = 0.02;
+	unsigned long size_reference = 0;
+
+	//the thumbnail still entropy decodes the whole frame, so frames of about the same size are only checked on it every
+	//probe_interval frames and dropped on their size in between
+	int probe_interval = 4;
+	int probe_count = 0;
+
+	//a block counts as changed when its mean luma moved by more than diff_threshold from the reference thumbnail, probes
+	//with fewer than changed_blocks_min changed blocks are dropped
+	int diff_threshold = 8;
+	int changed_blocks_min = 2;
+
+	//still let a frame through now and then so that background and exposure state keep up
+	int frames_skipped_max = 30;
+	int frames_skipped = 0;
+
+	//taken again from the first frame after the size settled, the one from before the motion says nothing about the scene
+	Mat image_thumbnail_reference;
+	bool thumbnail_reference_valid = false;
+
+	MotionGate();
+	bool compute(MJPEGFrame& frame);
+	void reset();
+
+private:
+	bool compute_thumbnail_changed(Mat& image_thumbnail);
+};
\ No newline at end of file
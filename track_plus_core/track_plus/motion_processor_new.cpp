@@ -18,6 +18,7 @@
 
 #include "motion_processor_new.h"
 #include "mat_functions.h"
+#include "profile_functions.h"
 #include "contour_functions.h"
 #include "console_log.h"
 #include "camera_initializer_new.h"
@@ -26,8 +27,50 @@ float subtraction_threshold_ratio = 0.20;
 int gray_threshold_range = 20;
 float alpha = 1;
 
-bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  const int y_ref, float pitch,
-								 bool construct_background, string name,     bool visualize)
+MotionProcessorStereo motion_processor_stereo;
+
+//y_max of the largest blob of the row profile drawn as bars from x = 0, the way BlobDetectorNew labels that image: rows of
+//a run touch at x = 1, seeds only come from rows 1 .. HEIGHT_SMALL - 3 and the outer rows join through the row next to
+//them where both bars overlap inside x = 1 .. WIDTH_SMALL - 2, ties go to the upper run
+static int get_profile_blob_y_max(const int* profile)
+{
+	ProfileRun runs[HEIGHT_SMALL / 2 + 1];
+	const int run_count = get_profile_runs(profile, HEIGHT_SMALL, runs);
+
+	int y_max = 0;
+	int count_max = 0;
+	for (int k = 0; k < run_count; ++k)
+	{
+		const int j_begin = max(runs[k].begin, 1);
+		const int j_end = min(runs[k].end, HEIGHT_SMALL - 2);
+		if (j_begin > j_end || j_begin > HEIGHT_SMALL - 3)
+			continue;
+
+		int count = runs[k].sum;
+		int y_max_run = j_end;
+
+		if (runs[k].begin == 0)
+			count += max(min(min(profile[0], profile[1]), WIDTH_SMALL_MINUS) - 1, 0) - profile[0];
+
+		if (runs[k].end == HEIGHT_SMALL_MINUS)
+		{
+			const int count_outer = max(min(min(profile[HEIGHT_SMALL_MINUS], profile[HEIGHT_SMALL - 2]), WIDTH_SMALL_MINUS) - 1, 0);
+			count += count_outer - profile[HEIGHT_SMALL_MINUS];
+			if (count_outer > 0)
+				y_max_run = HEIGHT_SMALL_MINUS;
+		}
+
+		if (count > count_max)
+		{
+			count_max = count;
+			y_max = y_max_run;
+		}
+	}
+	return y_max;
+}
+
+bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_in_small, Mat& image_raw, const int y_ref, float pitch,
+								 bool construct_background, string name,          bool visualize)
 {
 	if (value_store.get_bool("first_pass", false) == false)
 	{
@@ -37,8 +80,7 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 
 	//------------------------------------------------------------------------------------------------------------------------
 
-	Mat image_small;
-	resize(image_in, image_small, Size(WIDTH_SMALL_HALF, HEIGHT_SMALL_HALF), 0, 0, INTER_LINEAR);
+	Mat image_small = image_in_small;
 	Mat image_background_small = value_store.get_mat("image_background_small", true);
 
 	Mat image_subtraction_small = Mat::zeros(HEIGHT_SMALL_HALF, WIDTH_SMALL_HALF, CV_8UC1);
@@ -54,7 +96,9 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 			image_subtraction_small.ptr<uchar>(j, i)[0] = diff;
 		}
 
-	value_store.set_mat("image_background_small", image_small);
+	//the input belongs to a pipeline slot that gets reused, the background keeps its own copy
+	image_small.copyTo(image_background_small);
+	value_store.set_mat("image_background_small", image_background_small);
 	threshold(image_subtraction_small, image_subtraction_small, diff_max_small * subtraction_threshold_ratio, 254, THRESH_BINARY);
 
 	BlobDetectorNew* blob_detector_image_subtraction_small = value_store.get_blob_detector("blob_detector_image_subtraction_small");
@@ -64,7 +108,7 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 	{
 		bool ret_val = value_store.get_bool("result", false);
 		if (ret_val)
-			algo_name_vec.push_back(algo_name);
+			register_algo_name(algo_name);
 
 		return ret_val;
 	}
@@ -107,6 +151,20 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 	left_moving = false;
 	right_moving = false;
 
+	if (!background_model.compute(image_in))
+	{
+		image_background_static.setTo(255);
+		refill_background_static = true;
+	}
+	else if (compute_background_static || refill_background_static)
+	{
+		background_model.fill_unknown(image_background_static);
+
+		//pixels still unknown after the model had time to lock in are under a hand, they are left to the hand aware fills
+		if (background_model.frame_count >= background_model.lock_in * 2)
+			refill_background_static = false;
+	}
+
 	//------------------------------------------------------------------------------------------------------------------------
 
 	int current_frame = value_store.get_int("current_frame", 0);
@@ -126,7 +184,7 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 	{
 		bool ret_val = value_store.get_bool("result", false);
 		if (ret_val)
-			algo_name_vec.push_back(algo_name);
+			register_algo_name(algo_name);
 
 		return ret_val;
 	}
@@ -151,14 +209,15 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 	{
 		bool ret_val = value_store.get_bool("result", false);
 		if (ret_val)
-			algo_name_vec.push_back(algo_name);
+			register_algo_name(algo_name);
 
 		return ret_val;
 	}
 
 	threshold(image_subtraction_unbiased, image_subtraction_unbiased, diff_max_unbiased * subtraction_threshold_ratio, 254, THRESH_BINARY);
 
-	value_store.set_mat("image_background_unbiased", image_in);
+	image_in.copyTo(image_background_unbiased);
+	value_store.set_mat("image_background_unbiased", image_background_unbiased);
 
 	//------------------------------------------------------------------------------------------------------------------------
 
@@ -198,76 +257,32 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 
 		int intensity_array[WIDTH_SMALL] { 0 };
 		for (BlobNew& blob : *blob_detector_image_subtraction_unbiased->blobs)
-			for (Point& pt : blob.data)
-				++intensity_array[pt.x];
+			for (BlobSpan& span : blob.spans)
+				for (int i = span.i_begin; i <= span.i_end; ++i)
+					++intensity_array[i];
 
-		vector<Point> hist_pt_vec;
 		for (int i = 0; i < WIDTH_SMALL; ++i)
 		{
 			int j = intensity_array[i];
 			low_pass_filter->compute(j, 0.5, "histogram_j");
 
 			if (j < 10)
-				continue;
+				j = 0;
 
-			for (int j_current = 0; j_current < j; ++j_current)
-				hist_pt_vec.push_back(Point(i, j_current));
+			intensity_array[i] = j;
 		}
 
 		Point seed0 = Point(x_min, 0);
 		Point seed1 = Point(x_max, 0);
 
-		vector<Point> seed_vec0;
-		vector<Point> seed_vec1;
-
-		while (true)
-		{
-			seed_vec0.clear();
-			seed_vec1.clear();
-
-			for (Point& pt : hist_pt_vec)
-			{
-				float dist0 = get_distance(pt, seed0, false);
-				float dist1 = get_distance(pt, seed1, false);
-
-				if (dist0 < dist1)
-					seed_vec0.push_back(pt);
-				else
-					seed_vec1.push_back(pt);
-			}
-
-			if (seed_vec0.size() == 0 || seed_vec1.size() == 0)
-				break;
-
-			Point seed0_new = Point(0, 0);
-			for (Point& pt : seed_vec0)
-			{
-				seed0_new.x += pt.x;
-				seed0_new.y += pt.y;
-			}
-			seed0_new.x /= seed_vec0.size();
-			seed0_new.y /= seed_vec0.size();
-
-			Point seed1_new = Point(0, 0);
-			for (Point& pt : seed_vec1)
-			{
-				seed1_new.x += pt.x;
-				seed1_new.y += pt.y;
-			}
-			seed1_new.x /= seed_vec1.size();
-			seed1_new.y /= seed_vec1.size();
-
-			if (seed0 == seed0_new && seed1 == seed1_new)
-				break;
-
-			seed0 = seed0_new;
-			seed1 = seed1_new;
-		}
+		int x_seed_vec0_max_new;
+		int x_seed_vec1_min_new;
+		const bool split = split_profile(intensity_array, WIDTH_SMALL, seed0, seed1, x_seed_vec0_max_new, x_seed_vec1_min_new);
 
-		if (seed_vec0.size() > 0 && seed_vec1.size() > 0)
+		if (split)
 		{
-			x_seed_vec0_max = seed_vec0[seed_vec0.size() - 1].x;
-			x_seed_vec1_min = seed_vec1[0].x;
+			x_seed_vec0_max = x_seed_vec0_max_new;
+			x_seed_vec1_min = x_seed_vec1_min_new;
 
 			low_pass_filter->compute_if_smaller(x_seed_vec0_max, 0.5, "x_seed_vec0_max");
 			low_pass_filter->compute_if_larger(x_seed_vec1_min, 0.5, "x_seed_vec1_min");
@@ -281,11 +296,9 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 			{
 				Mat image_histogram = Mat::zeros(HEIGHT_SMALL, WIDTH_SMALL, CV_8UC1);
 
-				for (Point& pt : seed_vec0)
-					line(image_histogram, pt, Point(pt.x, 0), Scalar(127), 1);
-
-				for (Point& pt : seed_vec1)
-					line(image_histogram, pt, Point(pt.x, 0), Scalar(254), 1);
+				for (int i = 0; i < WIDTH_SMALL; ++i)
+					if (intensity_array[i] > 0)
+						line(image_histogram, Point(i, intensity_array[i] - 1), Point(i, 0), Scalar(i <= x_seed_vec0_max_new ? 127 : 254), 1);
 
 				circle(image_histogram, seed0, 5, Scalar(64), -1);
 				circle(image_histogram, seed1, 5, Scalar(64), -1);
@@ -293,7 +306,7 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 				line(image_histogram, Point(x_seed_vec0_max, 0), Point(x_seed_vec0_max, 9999), Scalar(64), 1);
 				line(image_histogram, Point(x_seed_vec1_min, 0), Point(x_seed_vec1_min, 9999), Scalar(64), 1);
 
-				imshow("image_histogramasd" + name, image_histogram);
+				post_imshow("image_histogramasd" + name, image_histogram);
 			}
 			#endif
 
@@ -333,28 +346,24 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 			}
 		}
 
-		static bool both_moving0 = false;
-		static bool both_moving1 = false;
-		static bool both_moving_old0 = false;
-		static bool both_moving_old1 = false;
+		MotionProcessorStereo& stereo = motion_processor_stereo;
+		if (name == "1")
+			stereo.gate_moving.wait();
 
 		if (name == "0")
 		{
-			both_moving_old0 = both_moving0;
-			both_moving0 = both_moving_temp;
+			stereo.both_moving_old0 = stereo.both_moving0;
+			stereo.both_moving0 = both_moving_temp;
 		}
 		else if (name == "1")
 		{
-			both_moving_old1 = both_moving1;
-			both_moving1 = both_moving_temp;
+			stereo.both_moving_old1 = stereo.both_moving1;
+			stereo.both_moving1 = both_moving_temp;
 		}
 
-		if (both_moving0 || both_moving_old0 || both_moving1 || both_moving_old1)
+		if (stereo.both_moving0 || stereo.both_moving_old0 || stereo.both_moving1 || stereo.both_moving_old1)
 			both_moving = true;
 
-		static bool both_moving_0_set = false;
-		static bool both_moving_1_set = false;
-
 		if (both_moving)
 		{
 			left_moving = true;
@@ -378,12 +387,12 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 
 			//------------------------------------------------------------------------------------------------------------------------
 
-			if (both_moving_0_set == false || both_moving_1_set == false)
+			if (stereo.both_moving_0_set == false || stereo.both_moving_1_set == false)
 			{
 				if (name == "0")
-					both_moving_0_set = true;
+					stereo.both_moving_0_set = true;
 				if (name == "1")
-					both_moving_1_set = true;
+					stereo.both_moving_1_set = true;
 			}
 		}
 		else if (entropy_left > entropy_threshold || entropy_right > entropy_threshold)
@@ -396,7 +405,11 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 
 		//------------------------------------------------------------------------------------------------------------------------
 
-		if (both_moving_0_set && both_moving_1_set)
+		const bool both_moving_set = stereo.both_moving_0_set && stereo.both_moving_1_set;
+		if (name == "0")
+			stereo.gate_moving.open();
+
+		if (both_moving_set)
 		{
 			Mat image_background = value_store.get_mat("image_background", true);
 			Mat image_subtraction = Mat::zeros(HEIGHT_SMALL, WIDTH_SMALL, CV_8UC1);
@@ -459,40 +472,25 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 
 			int intensity_array0[HEIGHT_SMALL] { 0 };
 			for (BlobNew& blob : *blob_detector_image_subtraction->blobs)//mark
-				for (Point& pt : blob.data)
-					++intensity_array0[pt.y];
+				for (BlobSpan& span : blob.spans)
+					intensity_array0[span.j] += span.i_end - span.i_begin + 1;
 
-			int y_min = 9999;
-			int y_max = 0;
-
-			vector<Point> hist_pt_vec0;
 			for (int i = 0; i < HEIGHT_SMALL; ++i)
 			{
 				int j = intensity_array0[i];
 				low_pass_filter->compute(j, 0.5, "histogram_j");
 
 				if (j < 10)
-					continue;
-
-				for (int j_current = 0; j_current < j; ++j_current)
-					hist_pt_vec0.push_back(Point(j_current, i));
+					j = 0;
 
-				if (i < y_min)
-					y_min = i;
-				if (i > y_max)
-					y_max = i;
+				intensity_array0[i] = j;
 			}
 
-			Mat image_histogram = Mat::zeros(HEIGHT_SMALL, WIDTH_SMALL, CV_8UC1);
-			for (Point& pt : hist_pt_vec0)
-				line(image_histogram, pt, Point(0, pt.y), Scalar(254), 1);
-
-			BlobDetectorNew* blob_detector_image_histogram = value_store.get_blob_detector("blob_detector_image_histogram");
-			blob_detector_image_histogram->compute(image_histogram, 254, 0, WIDTH_SMALL, 0, HEIGHT_SMALL, true);
+			const int y_histogram_max = get_profile_blob_y_max(intensity_array0);
 
 			if (both_moving)
 			{
-				y_separator_down = blob_detector_image_histogram->blob_max_size->y_max;
+				y_separator_down = y_histogram_max;
 				value_store.set_int("y_separator_down", y_separator_down);
 
 				y_separator_down_median = y_separator_down;
@@ -501,7 +499,7 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 			else if (left_moving || right_moving)
 			{
 				y_separator_down = value_store.get_int("y_separator_down");
-				int y_separator_down_new = blob_detector_image_histogram->blob_max_size->y_max;
+				int y_separator_down_new = y_histogram_max;
 				if (y_separator_down_new > y_separator_down)
 					y_separator_down = y_separator_down_new;
 			}
@@ -560,9 +558,6 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 
 					//------------------------------------------------------------------------------------------------------------------------
 
-					static float gray_threshold_left_stereo = 9999;
-					static float gray_threshold_right_stereo = 9999;
-
 					if (name == "0")
 					{
 						vector<uchar> gray_vec_left;
@@ -571,21 +566,13 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 						for (BlobNew& blob : *(blob_detector_image_subtraction->blobs))
 							if (blob.active)
 	                        {
-								if (blob.x < x_separator_middle)
+								vector<uchar>& gray_vec = blob.x < x_separator_middle ? gray_vec_left : gray_vec_right;
+								for (BlobSpan& span : blob.spans)
 								{
-									for (Point pt : blob.data)
-									{
-										uchar gray = std::max(image_in.ptr<uchar>(pt.y, pt.x)[0], image_background.ptr<uchar>(pt.y, pt.x)[0]);
-										gray_vec_left.push_back(gray);
-									}
-								}
-								else
-								{
-									for (Point pt : blob.data)
-									{
-										uchar gray = std::max(image_in.ptr<uchar>(pt.y, pt.x)[0], image_background.ptr<uchar>(pt.y, pt.x)[0]);
-										gray_vec_right.push_back(gray);
-									}	
+									const uchar* row_in = image_in.ptr<uchar>(span.j);
+									const uchar* row_background = image_background.ptr<uchar>(span.j);
+									for (int i = span.i_begin; i <= span.i_end; ++i)
+										gray_vec.push_back(std::max(row_in[i], row_background[i]));
 								}
 	                        }
 
@@ -596,7 +583,7 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 
 							gray_threshold_left = gray_median_left - gray_threshold_range;
 							low_pass_filter->compute(gray_threshold_left, 0.1, "gray_threshold_left");
-							gray_threshold_left_stereo = gray_threshold_left;
+							stereo.gray_threshold_left = gray_threshold_left;
 						}
 
 						if (gray_vec_right.size() > 0 && right_moving)
@@ -606,13 +593,14 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 
 							gray_threshold_right = gray_median_right - gray_threshold_range;
 							low_pass_filter->compute(gray_threshold_right, 0.1, "gray_threshold_right");
-							gray_threshold_right_stereo = gray_threshold_right;
+							stereo.gray_threshold_right = gray_threshold_right;
 						}
 					}
 					else
 					{
-						gray_threshold_left = gray_threshold_left_stereo;
-						gray_threshold_right = gray_threshold_right_stereo;
+						stereo.gate_thresholds.wait();
+						gray_threshold_left = stereo.gray_threshold_left;
+						gray_threshold_right = stereo.gray_threshold_right;
 					}
 
 					//------------------------------------------------------------------------------------------------------------------------
@@ -638,14 +626,14 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 										static_diff_max = diff;
 								}
 
-					static float diff_threshold_stereo;
 					if (name == "0")
 					{
 						diff_threshold = static_diff_max * 0.2;
-						diff_threshold_stereo = diff_threshold;
+						stereo.diff_threshold = diff_threshold;
+						stereo.gate_thresholds.open();
 					}
 					else
-						diff_threshold = diff_threshold_stereo;
+						diff_threshold = stereo.diff_threshold;
 
 					//------------------------------------------------------------------------------------------------------------------------
 
@@ -658,12 +646,19 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 								image_in_thresholded.ptr<uchar>(j, i)[0] = 0;
 
 					for (BlobNew& blob : *(blob_detector_image_subtraction->blobs))
-						for (Point& pt : blob.data)
+						for (Point& pt : blob.get_data())
 							if (image_in_thresholded.ptr<uchar>(pt.y, pt.x)[0] == 127)
 								floodFill(image_in_thresholded, pt, Scalar(254));
 
 					dilate(image_in_thresholded, image_in_thresholded, Mat(), Point(-1, -1), 3);
 
+					//the hand (filled from the moving blobs) and the motion stay out of the background model, or a hand that
+					//holds still for lock_in frames would be filled into image_background_static
+					Mat image_model_skip;
+					threshold(image_in_thresholded, image_model_skip, 127, 254, THRESH_BINARY);
+					bitwise_or(image_model_skip, image_subtraction_unbiased, image_model_skip);
+					background_model.exclude(image_model_skip);
+
 					//------------------------------------------------------------------------------------------------------------------------
 
 					Mat image_borders = value_store.get_mat("image_borders", true);
@@ -752,13 +747,17 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 					for (BlobNew& blob : *blob_detector_image_in_thresholded->blobs)
 					{
 						float overlap_count = 0;
-						for (Point& pt : blob.data)
-							if (image_borders.ptr<uchar>(pt.y, pt.x)[0] > 0)
-								++overlap_count;
+						for (BlobSpan& span : blob.spans)
+						{
+							const uchar* row_borders = image_borders.ptr<uchar>(span.j);
+							for (int i = span.i_begin; i <= span.i_end; ++i)
+								if (row_borders[i] > 0)
+									++overlap_count;
+						}
 
 						const float overlap_ratio = overlap_count / blob.count;
 						if (overlap_ratio > 0.5 || blob.x < x_separator_left || blob.x > x_separator_right || blob.y > y_separator_down)
-							for (Point& pt : blob.data)
+							for (Point& pt : blob.get_data())
 								fill_image_background_static(pt.x, pt.y, image_in); //out of bounds blob fill
 					}
 
@@ -852,7 +851,7 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 						int entropy_y_max_right = -1;
 
 						for (BlobNew& blob : *blob_detector_image_subtraction_unbiased->blobs)
-							for (Point& pt : blob.data)
+							for (Point& pt : blob.get_data())
 							{
 								int i = pt.x;
 								int j = pt.y;
@@ -930,15 +929,15 @@ bool MotionProcessorNew::compute(Mat& image_in,             Mat& image_raw,  con
 					line(image_visualization, pt_intersection_up_left, pt_intersection_down_left, Scalar(254), 1);
 					line(image_visualization, pt_intersection_up_right, pt_intersection_down_right, Scalar(254), 1);
 
-					imshow("image_visualizationadfasdfdfdfsff" + name, image_visualization);
-					imshow("image_subtractionsdfsdfsdfsaddddf" + name, image_subtraction);
+					post_imshow("image_visualizationadfasdfdfdfsff" + name, image_visualization);
+					post_imshow("image_subtractionsdfsdfsdfsaddddf" + name, image_subtraction);
 				}
 			}
 		}
 	}
 	bool ret_val = value_store.get_bool("result", false);
 	if (ret_val)
-		algo_name_vec.push_back(algo_name);
+		register_algo_name(algo_name);
 
 	return ret_val;
 }
@@ -21,6 +21,8 @@
 #include "globals.h"
 #include "value_store.h"
 #include "value_accumulator.h"
+#include "job_worker.h"
+#include "background_model.h"
 
 class MotionProcessorNew
 {
@@ -51,6 +53,8 @@ public:
 	bool will_compute_next_frame = false;
 
 	bool compute_background_static = false;
+	//set when a lighting change wiped image_background_static, the model fills it again even after construction
+	bool refill_background_static = false;
 	bool compute_x_separator_middle = true;
 
 	bool both_moving;
@@ -65,9 +69,36 @@ public:
 
 	ValueAccumulator value_accumulator;
 
-	bool compute(Mat& image_in,             Mat& image_raw, const int y_ref, float pitch,
-				 bool construct_background, string name,    bool visualize);
+	//per pixel running statistics, fills the pixels of image_background_static that are still unknown once they are stable
+	BackgroundModel background_model;
+
+	//image_in_small is image_in at half size
+	bool compute(Mat& image_in,             Mat& image_in_small, Mat& image_raw, const int y_ref, float pitch,
+				 bool construct_background, string name,         bool visualize);
 
 	inline void fill_image_background_static(const int x, const int y, Mat& image_in);
 	Mat compute_image_foreground(Mat& image_in);
-};
\ No newline at end of file
+};
+
+//state side "0" hands over to side "1" within a frame, each gate is opened by side "0" as soon as it has published
+//what side "1" waits on it for, and once more when side "0" returns in case it never got there
+struct MotionProcessorStereo
+{
+	bool both_moving0 = false;
+	bool both_moving1 = false;
+	bool both_moving_old0 = false;
+	bool both_moving_old1 = false;
+	bool both_moving_0_set = false;
+	bool both_moving_1_set = false;
+
+	float gray_threshold_left = 9999;
+	float gray_threshold_right = 9999;
+	float diff_threshold = 0;
+
+	//both_moving0 and both_moving_0_set, opened once side "0" is also done reading what side "1" set last frame
+	JobGate gate_moving;
+	//gray_threshold_left, gray_threshold_right and diff_threshold
+	JobGate gate_thresholds;
+};
+
+extern MotionProcessorStereo motion_processor_stereo;
\ No newline at end of file
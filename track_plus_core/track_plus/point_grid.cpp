@@ -0,0 +1,155 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "point_grid.h"
+
+static inline int get_cell_x(const int x)
+{
+	return min(max(x / POINT_GRID_CELL_SIZE, 0), POINT_GRID_WIDTH - 1);
+}
+
+static inline int get_cell_y(const int y)
+{
+	return min(max(y / POINT_GRID_CELL_SIZE, 0), POINT_GRID_HEIGHT - 1);
+}
+
+void PointGrid::compute(vector<Point>& points_in, vector<int>& labels_in)
+{
+	points = points_in;
+	labels = labels_in;
+
+	const int cell_count = POINT_GRID_WIDTH * POINT_GRID_HEIGHT;
+	memset(cell_begin, 0, sizeof(cell_begin));
+
+	for (Point& pt : points)
+		++cell_begin[get_cell_y(pt.y) * POINT_GRID_WIDTH + get_cell_x(pt.x) + 1];
+
+	for (int c = 0; c < cell_count; ++c)
+		cell_begin[c + 1] += cell_begin[c];
+
+	//counting sort, filling in index order keeps every cell ascending
+	int cell_fill[POINT_GRID_WIDTH * POINT_GRID_HEIGHT];
+	memcpy(cell_fill, cell_begin, sizeof(cell_fill));
+
+	const int point_count = points.size();
+	cell_points.resize(point_count);
+	for (int a = 0; a < point_count; ++a)
+	{
+		const int c = get_cell_y(points[a].y) * POINT_GRID_WIDTH + get_cell_x(points[a].x);
+		cell_points[cell_fill[c]] = a;
+		++cell_fill[c];
+	}
+}
+
+void PointGrid::relabel(const int label_old, const int label_new)
+{
+	for (int& label : labels)
+		if (label == label_old)
+			label = label_new;
+}
+
+//distances stay integer here, squared when accurate
+int PointGrid::find_nearest_squared(const Point pt_in, const int label_skip, const bool accurate, int& dist_out)
+{
+	const int cell_x = get_cell_x(pt_in.x);
+	const int cell_y = get_cell_y(pt_in.y);
+	const int ring_max = max(max(cell_x, POINT_GRID_WIDTH - 1 - cell_x), max(cell_y, POINT_GRID_HEIGHT - 1 - cell_y));
+
+	int index_nearest = -1;
+	int dist_nearest = 0;
+
+	for (int ring = 0; ring <= ring_max; ++ring)
+	{
+		//every point of this ring is at least this far along one axis, a tie there could still take a lower index
+		if (index_nearest != -1 && ring > 0)
+		{
+			const int gap = (ring - 1) * POINT_GRID_CELL_SIZE + 1;
+			if (dist_nearest < (accurate ? gap * gap : gap))
+				break;
+		}
+
+		const int y_begin = max(cell_y - ring, 0);
+		const int y_end = min(cell_y + ring, POINT_GRID_HEIGHT - 1);
+		for (int y = y_begin; y <= y_end; ++y)
+		{
+			const bool ring_row = y == cell_y - ring || y == cell_y + ring;
+			const int x_step = ring_row || ring == 0 ? 1 : 2 * ring;
+
+			for (int x = cell_x - ring; x <= cell_x + ring; x += x_step)
+			{
+				if (x < 0 || x >= POINT_GRID_WIDTH)
+					continue;
+
+				const int c = y * POINT_GRID_WIDTH + x;
+				for (int k = cell_begin[c]; k < cell_begin[c + 1]; ++k)
+				{
+					const int index = cell_points[k];
+					if (labels[index] == label_skip)
+						continue;
+
+					const int x_diff = points[index].x - pt_in.x;
+					const int y_diff = points[index].y - pt_in.y;
+					const int dist = accurate ? x_diff * x_diff + y_diff * y_diff : abs(x_diff) + abs(y_diff);
+
+					if (index_nearest == -1 || dist < dist_nearest || (dist == dist_nearest && index < index_nearest))
+					{
+						index_nearest = index;
+						dist_nearest = dist;
+					}
+				}
+			}
+		}
+	}
+
+	dist_out = dist_nearest;
+	return index_nearest;
+}
+
+int PointGrid::find_nearest(const Point pt_in, const int label_skip, const bool accurate, float& dist_out)
+{
+	int dist;
+	const int index = find_nearest_squared(pt_in, label_skip, accurate, dist);
+	dist_out = accurate ? sqrt((float)dist) : dist;
+	return index;
+}
+
+bool PointGrid::find_closest_pair(vector<int>& indices0, const int label_skip, const bool accurate,
+								  int& index0_out, int& index1_out, float& dist_out)
+{
+	index0_out = -1;
+	index1_out = -1;
+	int dist_min = 0;
+
+	for (int index0 : indices0)
+	{
+		int dist;
+		const int index1 = find_nearest_squared(points[index0], label_skip, accurate, dist);
+		if (index1 == -1)
+			return false;
+
+		if (index0_out == -1 || dist < dist_min || (dist == dist_min && labels[index1] < labels[index1_out]))
+		{
+			index0_out = index0;
+			index1_out = index1;
+			dist_min = dist;
+		}
+	}
+
+	dist_out = accurate ? sqrt((float)dist_min) : dist_min;
+	return index0_out != -1;
+}
\ No newline at end of file
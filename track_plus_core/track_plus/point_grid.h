@@ -0,0 +1,56 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+#include "globals.h"
+
+using namespace std;
+using namespace cv;
+
+#define POINT_GRID_CELL_SIZE 8
+#define POINT_GRID_WIDTH     (WIDTH_SMALL / POINT_GRID_CELL_SIZE)
+#define POINT_GRID_HEIGHT    (HEIGHT_SMALL / POINT_GRID_CELL_SIZE)
+
+//uniform grid of buckets over the WIDTH_SMALL x HEIGHT_SMALL image for nearest point queries, every point carries a label
+//and queries skip one label, so sets can be merged by relabeling without building the grid again
+class PointGrid
+{
+public:
+	vector<Point> points;
+	vector<int> labels;
+
+	void compute(vector<Point>& points_in, vector<int>& labels_in);
+	void relabel(const int label_old, const int label_new);
+
+	//index of the point closest to pt_in that is not labeled label_skip, the lower index wins a tie, -1 when there is none,
+	//accurate picks euclidean over manhattan distance like get_distance
+	int find_nearest(const Point pt_in, const int label_skip, const bool accurate, float& dist_out);
+	//closest pair between the points in indices0, which are all labeled label_skip, and the points labeled otherwise,
+	//ties go to the lower label of the second point, then to the earlier point in indices0, then to the lower second index
+	bool find_closest_pair(vector<int>& indices0, const int label_skip, const bool accurate,
+						   int& index0_out, int& index1_out, float& dist_out);
+
+private:
+	int cell_begin[POINT_GRID_WIDTH * POINT_GRID_HEIGHT + 1];
+	//point indices bucketed by cell, ascending within a cell
+	vector<int> cell_points;
+
+	int find_nearest_squared(const Point pt_in, const int label_skip, const bool accurate, int& dist_out);
+};
\ No newline at end of file
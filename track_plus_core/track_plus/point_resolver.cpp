@@ -19,18 +19,16 @@
 #include "point_resolver.h"
 #include "mat_functions.h"
 
-BlobDetectorNew blob_detector_point_resolver;
-
 const int window_width = 50;
 const int window_height = 20;
 const int window_width_half = window_width / 2;
 const int window_height_half = window_height / 2;
 
-Point2f do_resolve(Point& pt_in,                    Mat& image_in,
+Point2f do_resolve(Point& pt_in,                    MJPEGFrame& frame,
 	               Mat& image_background_in,        const uchar diff_threshold,
 			   	   const uchar gray_threshold_left, const uchar gray_threshold_right,
 				   Reprojector* reprojector,        const uchar side,
-										  		    const int x_separator_middle)
+				   BlobDetectorNew& blob_detector,  const int x_separator_middle)
 {
 	Point pt_large = pt_in * 4;
 
@@ -60,11 +58,14 @@ Point2f do_resolve(Point& pt_in,                    Mat& image_in,
 
 	Rect crop_rect_small = Rect(x0 / 4, y0 / 4, crop_rect_small_width, crop_rect_small_height);
 
-	Mat image_cropped = image_in(crop_rect);
+	Mat image_cropped = frame.get_roi(crop_rect, side);
+	if (image_cropped.cols == 0)
+		return Point(-1, -1);
+
 	// GaussianBlur(image_cropped, image_cropped, Size(21, 21), 0, 0);
 
 	Mat image_cropped_preprocessed;
-	compute_channel_diff_image(image_cropped, image_cropped_preprocessed, true, "image_cropped_preprocessed");
+	compute_channel_diff_image(image_cropped, image_cropped_preprocessed, true);
 	Point pt_offset0;
 	image_cropped_preprocessed = reprojector->remap(&image_cropped_preprocessed, x0, y0, side, pt_offset0);
 
@@ -114,15 +115,16 @@ Point2f do_resolve(Point& pt_in,                    Mat& image_in,
 	float point_y = 0;
 	float point_count = 0;
 
-	blob_detector_point_resolver.compute(image_subtraction, 254, 0, image_subtraction.cols, 0, image_subtraction.rows, true);
-	if (blob_detector_point_resolver.blobs->size() <= 1)
+	blob_detector.compute(image_subtraction, 254, 0, image_subtraction.cols, 0, image_subtraction.rows, true);
+	if (blob_detector.blobs->size() <= 1)
 	{
-		for (BlobNew& blob : *blob_detector_point_resolver.blobs)
-			for (Point& pt : blob.data)
+		for (BlobNew& blob : *blob_detector.blobs)
+			for (BlobSpan& span : blob.spans)
 			{
-				point_x += pt.x;
-				point_y += pt.y;
-				++point_count;
+				const int span_count = span.i_end - span.i_begin + 1;
+				point_x += (span.i_begin + span.i_end) * span_count / 2;
+				point_y += span.j * span_count;
+				point_count += span_count;
 			}
 	}
 	else
@@ -131,7 +133,7 @@ Point2f do_resolve(Point& pt_in,                    Mat& image_in,
 		BlobNew* blob_x_diff_min = NULL;
 		int x_diff_min = 9999;
 
-		for (BlobNew& blob : *blob_detector_point_resolver.blobs)
+		for (BlobNew& blob : *blob_detector.blobs)
 		{
 			int x_diff = abs(blob.pt_y_min.x - x_middle);
 			if (x_diff < x_diff_min)
@@ -140,11 +142,12 @@ Point2f do_resolve(Point& pt_in,                    Mat& image_in,
 				x_diff_min = x_diff;
 			}
 		}
-		for (Point& pt : blob_x_diff_min->data)
+		for (BlobSpan& span : blob_x_diff_min->spans)
 		{
-			point_x += pt.x;
-			point_y += pt.y;
-			++point_count;
+			const int span_count = span.i_end - span.i_begin + 1;
+			point_x += (span.i_begin + span.i_end) * span_count / 2;
+			point_y += span.j * span_count;
+			point_count += span_count;
 		}
 	}
 	if (point_count == 0)
@@ -166,7 +169,7 @@ PointResolver::PointResolver(MotionProcessorNew& _motion_processor0, MotionProce
 	reprojector = &_reprojector;
 }
 
-Point2f PointResolver::compute(Point pt, Mat& image_color, uchar side)
+Point2f PointResolver::compute(Point pt, MJPEGFrame& frame, uchar side)
 {
 	MotionProcessorNew* motion_processor;
 	if (side == 0)
@@ -175,12 +178,13 @@ Point2f PointResolver::compute(Point pt, Mat& image_color, uchar side)
 		motion_processor = motion_processor1;
 
 	return do_resolve(pt,
-					  image_color,
+					  frame,
 					  motion_processor->image_background_static,
 					  motion_processor->diff_threshold,
 					  motion_processor->gray_threshold_left,
 					  motion_processor->gray_threshold_right,
 					  reprojector,
 					  side,
+					  side == 0 ? blob_detector0 : blob_detector1,
 					  motion_processor->x_separator_middle);
 }
\ No newline at end of file
@@ -20,6 +20,8 @@
 
 #include "reprojector.h"
 #include "motion_processor_new.h"
+#include "mjpeg_frame.h"
+#include "blob_detector_new.h"
 
 class PointResolver
 {
@@ -28,7 +30,10 @@ public:
 	MotionProcessorNew* motion_processor1;
 	Reprojector* reprojector;
 
+	BlobDetectorNew blob_detector0;
+	BlobDetectorNew blob_detector1;
+
 	PointResolver(MotionProcessorNew& _motion_processor0, MotionProcessorNew& _motion_processor1, Reprojector& _reprojector);
 
-	Point2f compute(Point pt, Mat& image_color, uchar side);
+	Point2f compute(Point pt, MJPEGFrame& frame, uchar side);
 };
\ No newline at end of file
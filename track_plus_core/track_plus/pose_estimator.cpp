@@ -366,7 +366,7 @@ void PoseEstimator::compute(vector<Point>& points_in, vector<Point>& vertex_poin
 			}
 		}
 
-		imshow("image_dist_min", image_dist_min);
+		post_imshow("image_dist_min", image_dist_min);
 	}
 
 	string pose_name_temp;
@@ -391,7 +391,6 @@ void PoseEstimator::compute(vector<Point>& points_in, vector<Point>& vertex_poin
 
 	if (show)
 	{
-		imshow("image_current", image_current);
-		waitKey(1);
+		post_imshow("image_current", image_current);
 	}
 }
\ No newline at end of file
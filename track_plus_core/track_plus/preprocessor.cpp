@@ -0,0 +1,188 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "preprocessor.h"
+
+//slots are only handed back once nothing reads them anymore, so their buffers are allocated once and then reused
+static void prepare_buffer(Mat& image, const int rows, const int cols, const int type)
+{
+	if (image.rows != rows || image.cols != cols || image.type() != type)
+		image = Mat(rows, cols, type);
+}
+
+static inline int reflect_101(int val, const int size)
+{
+	if (val < 0)
+		val = -val;
+	if (val >= size)
+		val = 2 * size - val - 2;
+
+	return val;
+}
+
+Preprocessor::Preprocessor()
+{
+	//same kernels and fixed point scale as the 8 bit path of GaussianBlur
+	Mat kernel_x_mat;
+	Mat kernel_y_mat;
+	getGaussianKernel(PREPROCESSOR_KERNEL_X_SIZE, 0, CV_32F).convertTo(kernel_x_mat, CV_32S, 1 << 8);
+	getGaussianKernel(PREPROCESSOR_KERNEL_Y_SIZE, 0, CV_32F).convertTo(kernel_y_mat, CV_32S, 1 << 8);
+
+	for (int i = 0; i < PREPROCESSOR_KERNEL_X_SIZE; ++i)
+		kernel_x[i] = kernel_x_mat.ptr<int>(i)[0];
+
+	for (int i = 0; i < PREPROCESSOR_KERNEL_Y_SIZE; ++i)
+		kernel_y[i] = kernel_y_mat.ptr<int>(i)[0];
+}
+
+bool Preprocessor::compute(MJPEGFrame& frame, PreprocessorSlot& slot, const bool yuv, const bool normalize, const bool set_norm_range,
+						   const bool low_pass)
+{
+	bool result = true;
+
+	uchar gray_min;
+	uchar gray_max;
+	compute_channel_diff(frame, slot, 0, yuv, gray_min, gray_max);
+
+	if (set_norm_range)
+		result = set_channel_diff_range(gray_min, gray_max, low_pass);
+
+	compute_channel_diff(frame, slot, 1, yuv, gray_min, gray_max);
+
+	uchar lut_normalize[256];
+	const bool do_normalize = normalize && build_channel_diff_normalize_lut(lut_normalize);
+
+	for (int side = 0; side < 2; ++side)
+	{
+		Mat& image_diff = image_channel_diff[side];
+
+		if (do_normalize)
+			for (int j = 0; j < image_diff.rows; ++j)
+				lut_row(image_diff.ptr<uchar>(j), image_diff.cols, lut_normalize);
+
+		rectangle(image_diff, Rect(0, 0, image_diff.cols, image_diff.rows), Scalar(0), 2);
+		compute_blur(slot, side);
+	}
+
+	return result;
+}
+
+void Preprocessor::compute_channel_diff(MJPEGFrame& frame, PreprocessorSlot& slot, const uchar side, const bool yuv, uchar& gray_min,
+										uchar& gray_max)
+{
+	Mat& image_in = yuv ? frame.image_y_small[side] : frame.image_small[side];
+	const int width = image_in.cols;
+	const int height = image_in.rows;
+
+	prepare_buffer(slot.image_small[side], height, width, image_in.type());
+	prepare_buffer(image_channel_diff[side], height, width, CV_8UC1);
+
+	const uchar* lut = get_channel_diff_lut();
+
+	uchar gray_min_current = 255;
+	uchar gray_max_current = 0;
+
+	for (int j = 0; j < height; ++j)
+	{
+		const int j_in = height - 1 - j;
+		uchar* row_diff = image_channel_diff[side].ptr<uchar>(j);
+
+		memcpy(slot.image_small[side].ptr<uchar>(j), image_in.ptr<uchar>(j_in), width * image_in.elemSize());
+
+		if (yuv)
+		{
+			const uchar* row_cb = frame.image_cb_small[side].ptr<uchar>(j_in);
+			const uchar* row_cr = frame.image_cr_small[side].ptr<uchar>(j_in);
+
+			for (int i = 0; i < width; ++i)
+				row_diff[i] = lut[(row_cb[i] << 8) + row_cr[i]];
+		}
+		else
+			channel_diff_row(image_in.ptr<uchar>(j_in), row_diff, width);
+
+		min_max_row(row_diff, width, gray_min_current, gray_max_current);
+	}
+
+	gray_min = gray_min_current;
+	gray_max = gray_max_current;
+}
+
+void Preprocessor::compute_blur(PreprocessorSlot& slot, const uchar side)
+{
+	Mat& image_in = image_channel_diff[side];
+	const int width = image_in.cols;
+	const int height = image_in.rows;
+	const int radius_x = PREPROCESSOR_KERNEL_X_SIZE / 2;
+	const int radius_y = PREPROCESSOR_KERNEL_Y_SIZE / 2;
+
+	Mat& image_out = slot.image_preprocessed[side];
+	Mat& image_out_small = slot.image_preprocessed_small[side];
+
+	prepare_buffer(image_out, height, width, CV_8UC1);
+	prepare_buffer(image_out_small, height / 2, width / 2, CV_8UC1);
+
+	for (int k = 0; k < PREPROCESSOR_KERNEL_Y_SIZE; ++k)
+		if (row_ring[k].size() != (size_t)width)
+			row_ring[k].resize(width);
+
+	//rows are filtered horizontally just before the vertical pass first needs them, so the ring stays in L1
+	int row_filtered_count = 0;
+
+	for (int j = 0; j < height; ++j)
+	{
+		const int row_needed_max = min(j + radius_y, height - 1);
+		for (; row_filtered_count <= row_needed_max; ++row_filtered_count)
+		{
+			const uchar* row_in = image_in.ptr<uchar>(row_filtered_count);
+			int* row_out = &row_ring[row_filtered_count % PREPROCESSOR_KERNEL_Y_SIZE][0];
+
+			for (int i = 0; i < width; ++i)
+			{
+				int sum = 0;
+				for (int k = -radius_x; k <= radius_x; ++k)
+					sum += kernel_x[k + radius_x] * row_in[reflect_101(i + k, width)];
+
+				row_out[i] = sum;
+			}
+		}
+
+		const int* rows[PREPROCESSOR_KERNEL_Y_SIZE];
+		for (int k = -radius_y; k <= radius_y; ++k)
+			rows[k + radius_y] = &row_ring[reflect_101(j + k, height) % PREPROCESSOR_KERNEL_Y_SIZE][0];
+
+		uchar* row_out = image_out.ptr<uchar>(j);
+		for (int i = 0; i < width; ++i)
+		{
+			int sum = 0;
+			for (int k = 0; k < PREPROCESSOR_KERNEL_Y_SIZE; ++k)
+				sum += kernel_y[k] * rows[k][i];
+
+			row_out[i] = saturate_cast<uchar>((sum + (1 << 15)) >> 16);
+		}
+
+		//2x2 box average, what resize with INTER_LINEAR does for an exact halving
+		if (j % 2 == 1)
+		{
+			const uchar* row_top = image_out.ptr<uchar>(j - 1);
+			uchar* row_small = image_out_small.ptr<uchar>(j / 2);
+
+			for (int i = 0; i < width / 2; ++i)
+				row_small[i] = (row_top[i * 2] + row_top[i * 2 + 1] + row_out[i * 2] + row_out[i * 2 + 1] + 2) >> 2;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <opencv2/opencv.hpp>
+#include "mjpeg_frame.h"
+#include "mat_functions.h"
+#include "globals.h"
+
+using namespace std;
+using namespace cv;
+
+#define PREPROCESSOR_KERNEL_X_SIZE 3
+#define PREPROCESSOR_KERNEL_Y_SIZE 9
+
+//turns the decoded small images of both sides into the blurred, normalized channel diff images in one pass per side,
+//equivalent to flip, compute_channel_diff_image, GaussianBlur(Size(3, 9)) and the half size resize of MotionProcessorNew
+//output of one frame, the pipeline owns a ring of slots and a slot is only written again after the stage that read it let go
+struct PreprocessorSlot
+{
+	//flipped small image, luma or BGR depending on what was decoded
+	Mat image_small[2];
+	Mat image_preprocessed[2];
+	//image_preprocessed at half size
+	Mat image_preprocessed_small[2];
+
+	atomic<bool> in_use;
+
+	PreprocessorSlot()
+	{
+		in_use = false;
+	}
+};
+
+class Preprocessor
+{
+public:
+	Preprocessor();
+
+	//returns false when the normalization range of side 0 moved, like compute_channel_diff_image with set_norm_range
+	bool compute(MJPEGFrame& frame, PreprocessorSlot& slot, const bool yuv, const bool normalize, const bool set_norm_range,
+				 const bool low_pass);
+
+private:
+	Mat image_channel_diff[2];
+
+	int kernel_x[PREPROCESSOR_KERNEL_X_SIZE];
+	int kernel_y[PREPROCESSOR_KERNEL_Y_SIZE];
+
+	//horizontally filtered rows, indexed by row % PREPROCESSOR_KERNEL_Y_SIZE
+	vector<int> row_ring[PREPROCESSOR_KERNEL_Y_SIZE];
+
+	void compute_channel_diff(MJPEGFrame& frame, PreprocessorSlot& slot, const uchar side, const bool yuv, uchar& gray_min,
+							  uchar& gray_max);
+	void compute_blur(PreprocessorSlot& slot, const uchar side);
+};
\ No newline at end of file
@@ -0,0 +1,149 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "profile_functions.h"
+
+int get_profile_runs(const int* profile, const int size, ProfileRun* runs)
+{
+	int run_count = 0;
+	for (int i = 0; i < size; ++i)
+	{
+		if (profile[i] <= 0)
+			continue;
+
+		if (i == 0 || profile[i - 1] <= 0)
+		{
+			ProfileRun& run_new = runs[run_count];
+			++run_count;
+
+			run_new.begin = i;
+			run_new.sum = 0;
+			run_new.value_max = 0;
+		}
+
+		ProfileRun& run = runs[run_count - 1];
+		run.end = i;
+		run.sum += profile[i];
+		if (profile[i] > run.value_max)
+			run.value_max = profile[i];
+	}
+	return run_count;
+}
+
+//y in [0, height) that are closer to seed0 than to seed1 form one run, [y_begin, y_end), because
+//|y - y0| - |y - y1| is monotonic in y, diff is the horizontal term |x - x0| - |x - x1| of that column
+static inline void get_run0(const int height, const int diff, const int y0, const int y1, int& y_begin, int& y_end)
+{
+	//|y - y0| - |y - y1| < k
+	const int k = -diff;
+
+	y_begin = 0;
+	y_end = 0;
+
+	if (y0 == y1)
+	{
+		if (k > 0)
+			y_end = height;
+	}
+	else if (y0 < y1)
+	{
+		if (k > y1 - y0)
+			y_end = height;
+		else if (k > y0 - y1)
+			y_end = (k + y0 + y1 + 1) / 2;
+	}
+	else
+	{
+		y_end = height;
+		if (k <= y1 - y0)
+			y_begin = height;
+		else if (k <= y0 - y1)
+			y_begin = (y0 + y1 - k) / 2 + 1;
+	}
+
+	y_begin = min(max(y_begin, 0), height);
+	y_end = min(max(y_end, y_begin), height);
+}
+
+//sum of y over [y_begin, y_end)
+static inline long long get_series_sum(const int y_begin, const int y_end)
+{
+	return (long long)(y_begin + y_end - 1) * (y_end - y_begin) / 2;
+}
+
+bool split_profile(const int* profile, const int size, Point& seed0, Point& seed1, int& x_vec0_max, int& x_vec1_min)
+{
+	long long count0 = 0;
+	long long count1 = 0;
+
+	for (int iteration = 0; iteration < PROFILE_SPLIT_ITERATIONS_MAX; ++iteration)
+	{
+		count0 = 0;
+		count1 = 0;
+
+		long long x_sum0 = 0;
+		long long y_sum0 = 0;
+		long long x_sum1 = 0;
+		long long y_sum1 = 0;
+
+		x_vec0_max = -1;
+		x_vec1_min = -1;
+
+		for (int i = 0; i < size; ++i)
+		{
+			const int height = profile[i];
+			if (height <= 0)
+				continue;
+
+			int y_begin;
+			int y_end;
+			get_run0(height, abs(i - seed0.x) - abs(i - seed1.x), seed0.y, seed1.y, y_begin, y_end);
+
+			const int column_count0 = y_end - y_begin;
+			const int column_count1 = height - column_count0;
+			const long long column_y_sum0 = get_series_sum(y_begin, y_end);
+
+			count0 += column_count0;
+			x_sum0 += (long long)i * column_count0;
+			y_sum0 += column_y_sum0;
+
+			count1 += column_count1;
+			x_sum1 += (long long)i * column_count1;
+			y_sum1 += get_series_sum(0, height) - column_y_sum0;
+
+			if (column_count0 > 0)
+				x_vec0_max = i;
+			if (column_count1 > 0 && x_vec1_min == -1)
+				x_vec1_min = i;
+		}
+
+		if (count0 == 0 || count1 == 0)
+			break;
+
+		const Point seed0_new = Point(x_sum0 / count0, y_sum0 / count0);
+		const Point seed1_new = Point(x_sum1 / count1, y_sum1 / count1);
+
+		if (seed0 == seed0_new && seed1 == seed1_new)
+			break;
+
+		seed0 = seed0_new;
+		seed1 = seed1_new;
+	}
+
+	return count0 > 0 && count1 > 0;
+}
\ No newline at end of file
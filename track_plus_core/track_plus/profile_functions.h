@@ -0,0 +1,45 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+
+//upper bound on 2-means iterations, the assignment usually settles within 5
+#define PROFILE_SPLIT_ITERATIONS_MAX 32
+
+//a profile is a histogram held as int bins, the functions below stand in for rasterizing it as bars and working on the image
+
+//inclusive range of consecutive nonzero bins
+struct ProfileRun
+{
+	int begin;
+	int end;
+	int sum;
+	int value_max;
+};
+
+//runs go to runs in order and the count is returned, runs must hold size / 2 + 1 entries
+int get_profile_runs(const int* profile, const int size, ProfileRun* runs);
+
+//2-means with manhattan distance over the points (i, 0 .. profile[i] - 1) of a column profile, seeds are updated in place
+//to the integer centroids, returns false when one of the clusters ends up empty, otherwise x_vec0_max is the rightmost
+//column with a point in cluster 0 and x_vec1_min the leftmost column with a point in cluster 1
+bool split_profile(const int* profile, const int size, Point& seed0, Point& seed1, int& x_vec0_max, int& x_vec1_min);
\ No newline at end of file
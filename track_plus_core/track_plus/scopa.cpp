@@ -24,6 +24,7 @@
 #include "permutation.h"
 #include "pose_estimator.h"
 #include "point_plus.h"
+#include "point_grid.h"
 
 struct ColorPointPlusPair
 {
@@ -33,7 +34,7 @@ struct ColorPointPlusPair
 	int color_index;
 	int point_index;
 
-	ColorPointPlusPair(Scalar& _color, PointPlus& _point, int _overlap, int _color_index, int _point_index)
+	ColorPointPlusPair(const Scalar& _color, PointPlus& _point, int _overlap, int _color_index, int _point_index)
 	{
 		color = _color;
 		point = _point;
@@ -101,14 +102,25 @@ struct compare_point_y
 	}
 };
 
-int x_diff_rotation;
-int y_diff_rotation;
-float hand_angle;
-Point palm_point;
-Point palm_point_rotated;
-float palm_radius;
+SCOPAStereo scopa_stereo;
 
-Point rotate_point_upright(Point& pt, float hand_angle_overwrite = 9999)
+vector<string> SCOPA::algo_name_vec;
+vector<string> SCOPA::algo_name_vec_old;
+mutex SCOPA::algo_name_mutex;
+
+void SCOPA::register_algo_name(const string algo_name)
+{
+	lock_guard<mutex> lock(algo_name_mutex);
+	algo_name_vec.push_back(algo_name);
+}
+
+void SCOPA::next_frame()
+{
+	algo_name_vec_old = algo_name_vec;
+	algo_name_vec.clear();
+}
+
+Point SCOPA::rotate_point_upright(Point& pt, float hand_angle_overwrite)
 {
 	Point pt_rotated = rotate_point(hand_angle_overwrite == 9999 ? -hand_angle : -hand_angle_overwrite, pt, palm_point);
 	pt_rotated.x += x_diff_rotation;
@@ -116,7 +128,7 @@ Point rotate_point_upright(Point& pt, float hand_angle_overwrite = 9999)
 	return pt_rotated;
 }
 
-Point rotate_point_normal(Point& pt)
+Point SCOPA::rotate_point_normal(Point& pt)
 {
 	Point pt_rotated = rotate_point(hand_angle, pt, palm_point_rotated);
 	pt_rotated.x -= x_diff_rotation;
@@ -188,13 +200,49 @@ void match_points_by_permutation(vector<PointPlus>* points0, vector<PointPlus>*
 	}
 }
 
+//breadth first from pt_seed over the pixels of one labeled blob, with the neighbor order of BlobDetectorNew::compute_location
+//and the 1 pixel border of the image left unexpanded, the visited pixels are marked 255 and put back to 254 afterwards
+static void flood_blob(Mat& image_in, Mat& image_atlas, const ushort atlas_id, Point pt_seed, vector<Point>& points_out)
+{
+	const int x_max = image_in.cols - 1;
+	const int y_max = image_in.rows - 1;
+
+	static const int dx[8] = { -1, 1, 0, 0, -1, 1, 1, -1 };
+	static const int dy[8] = { 0, 0, -1, 1, -1, 1, -1, 1 };
+
+	points_out.clear();
+	points_out.push_back(pt_seed);
+	image_in.ptr<uchar>(pt_seed.y)[pt_seed.x] = 255;
+
+	for (size_t k = 0; k < points_out.size(); ++k)
+	{
+		const Point pt = points_out[k];
+		if (pt.x <= 0 || pt.x >= x_max || pt.y <= 0 || pt.y >= y_max)
+			continue;
+
+		for (int n = 0; n < 8; ++n)
+		{
+			const int x = pt.x + dx[n];
+			const int y = pt.y + dy[n];
+
+			uchar& pix = image_in.ptr<uchar>(y)[x];
+			if (pix == 254 && image_atlas.ptr<ushort>(y)[x] == atlas_id)
+			{
+				points_out.push_back(Point(x, y));
+				pix = 255;
+			}
+		}
+	}
+
+	for (Point& pt : points_out)
+		image_in.ptr<uchar>(pt.y)[pt.x] = 254;
+}
+
 void draw_circle(Mat& image, Point pt, bool is_empty = false)
 {
 	circle(image, pt, 3, Scalar(127), is_empty ? 1 : -1);
 }
 
-ThinningComputer thinning_computer;
-
 vector<Point> stereo_matching_points0;
 vector<Point> stereo_matching_points1;
 
@@ -204,7 +252,7 @@ vector<Point> contour_processed1;
 vector<Scalar> color_vec0;
 vector<Scalar> color_vec1;
 
-vector<Scalar> colors;
+const vector<Scalar> colors = { Scalar(255, 0, 0), Scalar(0, 153, 0), Scalar(0, 0, 255), Scalar(153, 0, 102), Scalar(102, 102, 102) };
 
 vector<Point> vertex_points0;
 vector<Point> vertex_points1;
@@ -219,7 +267,7 @@ int x_max_pose1;
 int y_min_pose1;
 int y_max_pose1;
 
-bool SCOPA::compute_mono0(HandSplitterNew& hand_splitter, PoseEstimator& pose_estimator, const string name, bool visualize)
+bool SCOPA::compute_mono0(HandSplitterResult& hand_splitter, PoseEstimator& pose_estimator, const string name, bool visualize)
 {
 	int frame_count = value_store.get_int("frame_count", -1);
 	++frame_count;
@@ -256,21 +304,10 @@ bool SCOPA::compute_mono0(HandSplitterNew& hand_splitter, PoseEstimator& pose_es
 	pt_ring = Point(-1, -1);
 	pt_pinky = Point(-1, -1);
 
-	if (colors.size() == 0)
-	{
-		colors.push_back(Scalar(255, 0, 0));
-		colors.push_back(Scalar(0, 153, 0));
-		colors.push_back(Scalar(0, 0, 255));
-		colors.push_back(Scalar(153, 0, 102));
-		colors.push_back(Scalar(102, 102, 102));
-	}
-
-	//------------------------------------------------------------------------------------------------------------------------------
-
 	if (hand_splitter.blobs_right.size() == 0)
 		return false;
 
-	vector<BlobNew> blobs_hand = hand_splitter.blobs_right;
+	vector<BlobNew>& blobs_hand = hand_splitter.blobs_right;
 
 	const int x_min_hand_right = hand_splitter.x_min_result_right;
 	const int x_max_hand_right = hand_splitter.x_max_result_right;
@@ -291,20 +328,35 @@ bool SCOPA::compute_mono0(HandSplitterNew& hand_splitter, PoseEstimator& pose_es
 	int palm_point_raw_count = 0;
 	const int y_threshold = palm_point.y - palm_radius;
 
+	int x_min_hand = 9999;
+	int x_max_hand = 0;
+	int y_min_hand = 9999;
+	int y_max_hand = 0;
+
 	float count_total = 1;
 	for (BlobNew& blob : blobs_hand)
 	{
+		if (blob.x_min < x_min_hand)
+			x_min_hand = blob.x_min;
+		if (blob.x_max > x_max_hand)
+			x_max_hand = blob.x_max;
+		if (blob.y_min < y_min_hand)
+			y_min_hand = blob.y_min;
+		if (blob.y_max > y_max_hand)
+			y_max_hand = blob.y_max;
+
 		blob.fill(image_find_contours, 254);
 		blob.fill(image_active_hand, 254);
 		blob.fill(image_palm_segmented, 254);
 		blob.fill(image_visualization, 254);
 
-		for (Point& pt : blob.data)
-			if (pt.y > y_threshold)
+		for (BlobSpan& span : blob.spans)
+			if (span.j > y_threshold)
 			{
-				palm_point_raw.x += pt.x;
-				palm_point_raw.y += pt.y;
-				++palm_point_raw_count;
+				const int span_count = span.i_end - span.i_begin + 1;
+				palm_point_raw.x += (span.i_begin + span.i_end) * span_count / 2;
+				palm_point_raw.y += span.j * span_count;
+				palm_point_raw_count += span_count;
 			}
 		count_total += blob.count;
 	}
@@ -322,7 +374,7 @@ bool SCOPA::compute_mono0(HandSplitterNew& hand_splitter, PoseEstimator& pose_es
 	palm_point_raw.x /= palm_point_raw_count;
 	palm_point_raw.y /= palm_point_raw_count;
 
-	vector<vector<Point>> contours = legacyFindContours(image_find_contours);
+	contour_tracer.compute(image_find_contours, contours);
 	const int contours_size = contours.size();	
 
 	if (contours_size == 0)
@@ -331,122 +383,102 @@ bool SCOPA::compute_mono0(HandSplitterNew& hand_splitter, PoseEstimator& pose_es
 	}
 	else if (contours_size > 1)
 	{
-		vector<vector<Point>> contours_reduced(contours_size);
+		//every 4th point labeled by its contour, contour 0 takes in the contour closest to it one at a time
+		vector<Point> points_reduced;
+		vector<int> labels_reduced;
+		vector<int> contour_begin(contours_size + 1);
 
 		for (int i = 0; i < contours_size; ++i)
 		{
-			vector<Point>* contour_reduced = &(contours_reduced[i]);
-			vector<Point>* contour = &(contours[i]);
+			contour_begin[i] = points_reduced.size();
 
-			const int contour_size = contour->size();
+			const int contour_size = contours[i].size();
 			for (int a = 0; a < contour_size; a += 4)
-				contour_reduced->push_back((*contour)[a]);
+			{
+				points_reduced.push_back(contours[i][a]);
+				labels_reduced.push_back(i);
+			}
 		}
+		contour_begin[contours_size] = points_reduced.size();
 
 		image_find_contours = Mat::zeros(HEIGHT_SMALL, WIDTH_SMALL, CV_8UC1);
 		for (BlobNew& blob : blobs_hand)
 			blob.fill(image_find_contours, 254);
 
-		for (int i = 0; i < contours_reduced.size(); ++i)
-		{
-			if (contours_reduced.size() == 1)
-				break;
-
-			vector<Point>* contour0 = &(contours_reduced[i]);
+		PointGrid point_grid;
+		point_grid.compute(points_reduced, labels_reduced);
 
-			float dist_max = 9999;
-			int index_contour_dist_max;
-			Point pt_dist_max0;
-			Point pt_dist_max1;
+		vector<int> indices_merged;
+		for (int a = contour_begin[0]; a < contour_begin[1]; ++a)
+			indices_merged.push_back(a);
 
-			for (int a = 0; a < contours_reduced.size(); ++a)
-				if (a != i)
-				{
-					vector<Point>* contour1 = &(contours_reduced[a]);
-
-					for (Point& pt0 : *contour0)
-						for (Point& pt1 : *contour1)
-						{
-							const float dist_current = get_distance(pt0, pt1, false);
-
-							if (dist_current < dist_max)
-							{
-								dist_max = dist_current;
-								index_contour_dist_max = a;
-								pt_dist_max0 = pt0;
-								pt_dist_max1 = pt1;
-							}
-						}
-				}
+		for (int i = 1; i < contours_size; ++i)
+		{
+			int index0;
+			int index1;
+			float dist;
+			if (!point_grid.find_closest_pair(indices_merged, 0, false, index0, index1, dist))
+				break;
 
-			for (Point& pt : contours_reduced[index_contour_dist_max])
-				contour0->push_back(pt);
+			const int label = point_grid.labels[index1];
+			for (int a = contour_begin[label]; a < contour_begin[label + 1]; ++a)
+				indices_merged.push_back(a);
 
-			contours_reduced.erase(contours_reduced.begin() + index_contour_dist_max);
-			--i;
+			point_grid.relabel(label, 0);
 
-			line(image_find_contours, pt_dist_max0, pt_dist_max1, Scalar(254), 2);
+			line(image_find_contours, point_grid.points[index0], point_grid.points[index1], Scalar(254), 2);
 		}
 
-		contours = legacyFindContours(image_find_contours);
+		contour_tracer.compute(image_find_contours, contours);
 	}
 
 	//------------------------------------------------------------------------------------------------------------------------------
 
 	hand_angle = value_store.get_float("hand_angle", 0);
 
-	Mat image_very_small;
-	resize(image_active_hand, image_very_small, Size(WIDTH_MIN / 2, HEIGHT_MIN / 2), 0, 0, INTER_LINEAR);
-	threshold(image_very_small, image_very_small, 250, 254, THRESH_BINARY);
-
-	{
-		Mat image_distance_transform;
-		distanceTransform(image_very_small, image_distance_transform, CV_DIST_L2, CV_DIST_MASK_PRECISE);
+	//the hand with a ring of background around it gives the same distances as the whole image
+	const Rect rect_hand = Rect(Point(x_min_hand - 1, y_min_hand - 1), Point(x_max_hand + 2, y_max_hand + 2)) &
+						   Rect(0, 0, WIDTH_SMALL, HEIGHT_SMALL);
 
-		double min;
-		double max;
-		Point min_loc;
-		Point max_loc;
-		minMaxLoc(image_distance_transform, &min, &max, &min_loc, &max_loc);
+	Mat image_hand = image_active_hand(rect_hand);
+	Mat image_distance_transform;
 
-		palm_point = max_loc * 4;
-		palm_radius = max * 4;
+	{
+		float dist_min;
+		float dist_max;
+		Point pt_dist_min;
+		Point pt_dist_max;
+		distance_transform(image_hand, image_distance_transform, dist_min, dist_max, pt_dist_min, pt_dist_max);
+
+		palm_point = pt_dist_max + rect_hand.tl();
+		palm_radius = dist_max;
 	}
 	{
-		int x_min_ivst;
-		int x_max_ivst;
-		int y_min_ivst;
-		int y_max_ivst;
-		threshold_get_bounds(image_very_small, image_very_small, 250, x_min_ivst, x_max_ivst, y_min_ivst, y_max_ivst);
-
-		x_min_ivst += 2;
-		x_max_ivst += 2;
+		x_min_hand += 8;
+		x_max_hand += 8;
 
 		const float mask_ratio = 0.7;
 
-		const int i_max = x_max_ivst;
-		const int j_max = y_max_ivst;
-		for (int i = (x_max_ivst - x_min_ivst) * mask_ratio + x_min_ivst; i < i_max; ++i)
-			for (int j = y_min_ivst; j < j_max; ++j)
-				image_very_small.ptr<uchar>(j, i)[0] = 0;
-
-		Mat image_distance_transform;
-		distanceTransform(image_very_small, image_distance_transform, CV_DIST_L2, CV_DIST_MASK_PRECISE);
+		const int i_max = min(x_max_hand, WIDTH_SMALL);
+		const int j_max = y_max_hand;
+		for (int i = (x_max_hand - x_min_hand) * mask_ratio + x_min_hand; i < i_max; ++i)
+			for (int j = y_min_hand; j < j_max; ++j)
+				image_active_hand.ptr<uchar>(j, i)[0] = 0;
 
-		double min;
-		double max;
-		Point min_loc;
-		Point max_loc;
-		minMaxLoc(image_distance_transform, &min, &max, &min_loc, &max_loc);
+		float dist_min;
+		float dist_max;
+		Point pt_dist_min;
+		Point pt_dist_max;
+		distance_transform(image_hand, image_distance_transform, dist_min, dist_max, pt_dist_min, pt_dist_max);
 
-		palm_radius = max * 4;
+		palm_radius = dist_max;
 		// float multiplier = palm_radius > 10 ? 10 : palm_radius;
 		// multiplier = map_val(multiplier, 0, 10, 2, 1);
 		// palm_radius *= multiplier * 1.5;
 
 		const int x_offset = hand_angle > 0 ? 0 : (palm_radius / 2);
 
-		Point palm_point_new = max_loc * 4;
+		Point palm_point_new = pt_dist_max + rect_hand.tl();
 		palm_point.y = palm_point_new.y;
 		palm_point.x = palm_point_raw.x + x_offset;
 	}
@@ -454,11 +486,16 @@ bool SCOPA::compute_mono0(HandSplitterNew& hand_splitter, PoseEstimator& pose_es
 	low_pass_filter->compute(palm_radius, 0.1, "palm_radius");
 	low_pass_filter->compute(palm_point.y, 0.5, "palm_point");
 
-	static float palm_radius_static = 0;
 	if (name == "1")
-		palm_radius_static = palm_radius;
+	{
+		scopa_stereo.palm_radius = palm_radius;
+		scopa_stereo.gate_palm_radius.open();
+	}
 	else
-		palm_radius = palm_radius_static;
+	{
+		scopa_stereo.gate_palm_radius.wait();
+		palm_radius = scopa_stereo.palm_radius;
+	}
 
 	Point pt_palm = palm_point;
 
@@ -490,26 +527,26 @@ bool SCOPA::compute_mono0(HandSplitterNew& hand_splitter, PoseEstimator& pose_es
 
 		vector<Point> subject_points;
 		for (BlobNew& blob : blobs_hand)
-			for (Point& pt : blob.data)
+			for (Point& pt : blob.get_data())
 				subject_points.push_back(pt);
 
 		{
 			Point attach_pivot = Point(pt_palm.x, 0);
 
-			BlobNew blob0;
+			BlobNew* blob0 = &blobs_hand[0];
 			int count_max = 0;
 
 			for (BlobNew& blob : blobs_hand)
 				if (blob.count > count_max)
 				{
 					count_max = blob.count;
-					blob0 = blob;
+					blob0 = &blob;
 				}
 
 			Point pt_attach0;
-			float dist0 = blob0.compute_min_dist(attach_pivot, &pt_attach0, false);
+			float dist0 = blob0->compute_min_dist(attach_pivot, &pt_attach0, false);
 			for (BlobNew& blob1 : blobs_hand)
-				if (blob0.atlas_id != blob1.atlas_id)
+				if (blob0->atlas_id != blob1.atlas_id)
 				{
 					Point pt_attach1;
 					float dist1 = blob1.compute_min_dist(attach_pivot, &pt_attach1, false);
@@ -519,7 +556,7 @@ bool SCOPA::compute_mono0(HandSplitterNew& hand_splitter, PoseEstimator& pose_es
 					if (dist0 < dist1)
 					{
 						pt_attach = pt_attach1;
-						blob0.compute_min_dist(pt_attach, &pt_base, false);
+						blob0->compute_min_dist(pt_attach, &pt_base, false);
 					}
 					else
 					{
@@ -583,11 +620,34 @@ bool SCOPA::compute_mono0(HandSplitterNew& hand_splitter, PoseEstimator& pose_es
 
 		BlobDetectorNew* blob_detector_image_skeleton_parts = value_store.get_blob_detector("blob_detector_image_skeleton_parts");
 
+		//the same clamping as BlobDetectorNew::compute, a blob is seeded at its first pixel in the scanned region
+		const int i_min_segmented = max(x_min_hand_right, 1);
+		const int i_max_segmented = min(x_max_hand_right, WIDTH_SMALL - 2);
+		const int j_min_segmented = max(y_min_hand_right, 1);
+		const int j_max_segmented = min(y_max_hand_right, HEIGHT_SMALL - 2);
+
 		float dist_to_palm_max = -1;
 		for (BlobNew& blob : *blob_detector_image_skeleton_segmented->blobs)
 		{
+			Point pt_seed = Point(-1, -1);
+			for (BlobSpan& span : blob.spans)
+				if (span.j >= j_min_segmented && span.j < j_max_segmented &&
+					max(span.i_begin, i_min_segmented) <= min(span.i_end, i_max_segmented - 1))
+				{
+					pt_seed = Point(max(span.i_begin, i_min_segmented), span.j);
+					break;
+				}
+
+			if (pt_seed.x == -1)
+				continue;
+
+			//blobs are labeled in raster order, the origin is the first pixel next to a junction in breadth first order from
+			//the seed, which is the order the blob used to be flooded in
+			flood_blob(image_skeleton_segmented, blob_detector_image_skeleton_segmented->image_atlas, blob.atlas_id, pt_seed,
+					   skeleton_flood_points);
+
 			Point pt_origin = Point(-1, -1);
-			for (Point& pt : blob.data)
+			for (Point& pt : skeleton_flood_points)
 			{
 				bool to_break = false;
 				for (int a = -1; a <= 1; ++a)
@@ -725,11 +785,16 @@ bool SCOPA::compute_mono0(HandSplitterNew& hand_splitter, PoseEstimator& pose_es
 		}
 	}
 
-	static float hand_angle_static = 0;
 	if (name == "1")
-		hand_angle_static = hand_angle;
+	{
+		scopa_stereo.hand_angle = hand_angle;
+		scopa_stereo.gate_hand_angle.open();
+	}
 	else
-		hand_angle = hand_angle_static;
+	{
+		scopa_stereo.gate_hand_angle.wait();
+		hand_angle = scopa_stereo.hand_angle;
+	}
 
 	value_store.set_float("hand_angle", PoseEstimator::pose_name == "point" ? hand_angle - 20 : hand_angle);
 
@@ -1024,13 +1089,13 @@ bool SCOPA::compute_mono0(HandSplitterNew& hand_splitter, PoseEstimator& pose_es
 	{
 		circle(image_visualization, pt_palm, palm_radius, Scalar(127), 1);
 		circle(image_visualization, pt_palm_rotated, palm_radius, Scalar(127), 1);
-		imshow("image_visualizationadlfkjhasdlkf" + name, image_visualization);
-		imshow("image_labeled" + name, image_labeled);
+		post_imshow("image_visualizationadlfkjhasdlkf" + name, image_visualization);
+		post_imshow("image_labeled" + name, image_labeled);
 	}
 
 	//------------------------------------------------------------------------------------------------------------------------------
 
-	algo_name_vec.push_back(algo_name);
+	register_algo_name(algo_name);
 	return true;
 }
 
@@ -1050,7 +1115,7 @@ void SCOPA::compute_stereo()
 
 	color_point_map0.clear();
 	color_point_map1.clear();
-	for (Scalar& color : colors)
+	for (const Scalar& color : colors)
 	{
 		string key = to_string(color[0]) + "," + to_string(color[1]) + "," + to_string(color[2]);
 		color_point_map0[key] = vector<Point>();
@@ -1079,7 +1144,7 @@ void SCOPA::compute_stereo()
 	vector<Point> vertex_points0_temp;
 	vector<Point> vertex_points1_temp;
 
-	for (Scalar& color : colors)
+	for (const Scalar& color : colors)
 	{
 		string key = to_string(color[0]) + "," + to_string(color[1]) + "," + to_string(color[2]);
 		
@@ -1205,7 +1270,7 @@ void SCOPA::compute_mono1(string name)
 			y_max = HEIGHT_SMALL_MINUS;
 
 		int color_index = -1;
-		for (Scalar& color : colors)
+		for (const Scalar& color : colors)
 		{
 			++color_index;
 
@@ -1251,5 +1316,5 @@ void SCOPA::compute_mono1(string name)
 	*point_plus_vec_old = point_plus_vec;
 	value_store.set_int("tip_points_size_old", tip_points_size);
 
-	imshow("image_labeled_asdlkfjh" + name, image_labeled);
+	post_imshow("image_labeled_asdlkfjh" + name, image_labeled);
 }
\ No newline at end of file
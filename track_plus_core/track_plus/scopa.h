@@ -22,7 +22,9 @@
 #include "value_store.h"
 #include "value_accumulator.h"
 #include "thinning_computer_new.h"
+#include "contour_tracer.h"
 #include "pose_estimator.h"
+#include "job_worker.h"
 
 class SCOPA
 {
@@ -42,7 +44,46 @@ public:
 
 	vector<Point> tip_points;
 
-	bool compute_mono0(HandSplitterNew& hand_splitter, PoseEstimator& pose_estimator, const string name, bool visualize);
+	int x_diff_rotation = 0;
+	int y_diff_rotation = 0;
+	float hand_angle = 0;
+	Point palm_point;
+	Point palm_point_rotated;
+	float palm_radius = 0;
+
+	ThinningComputer thinning_computer;
+
+	//contours of the hand, refilled by each compute
+	ContourTracer contour_tracer;
+	vector<vector<Point>> contours;
+	//one skeleton part in breadth first order, refilled for every part
+	vector<Point> skeleton_flood_points;
+
+	//SCOPA runs a frame behind the hand splitter, so it keeps its own record of the instances that completed last frame
+	static vector<string> algo_name_vec;
+	static vector<string> algo_name_vec_old;
+	static mutex algo_name_mutex;
+
+	static void register_algo_name(const string algo_name);
+	static void next_frame();
+
+	Point rotate_point_upright(Point& pt, float hand_angle_overwrite = 9999);
+	Point rotate_point_normal(Point& pt);
+
+	bool compute_mono0(HandSplitterResult& hand_splitter, PoseEstimator& pose_estimator, const string name, bool visualize);
 	static void compute_stereo();
 	void compute_mono1(string name);
-};
\ No newline at end of file
+};
+
+//palm radius and hand angle side "1" hands over to side "0" within a frame, side "1" opens each gate as soon as the value
+//is written and once more when it returns in case it never got there
+struct SCOPAStereo
+{
+	float palm_radius = 0;
+	float hand_angle = 0;
+
+	JobGate gate_palm_radius;
+	JobGate gate_hand_angle;
+};
+
+extern SCOPAStereo scopa_stereo;
\ No newline at end of file
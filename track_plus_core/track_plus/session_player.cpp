@@ -0,0 +1,205 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "session_player.h"
+#include "console_log.h"
+
+SessionPlayer::SessionPlayer(const string _path, bool _realtime)
+{
+	path = _path;
+	realtime = _realtime;
+
+	stop_requested = false;
+	is_finished = false;
+}
+
+SessionPlayer::~SessionPlayer()
+{
+	stop();
+}
+
+bool SessionPlayer::load()
+{
+	ifs.open(path, ios::binary);
+	if (!ifs.is_open())
+	{
+		console_log("cannot open session file " + path);
+		return false;
+	}
+
+	char magic[4];
+	int version = 0;
+	ifs.read(magic, 4);
+	ifs.read((char*)&version, sizeof(version));
+
+	if (!ifs || string(magic, 4) != SESSION_MAGIC || version != SESSION_VERSION)
+	{
+		console_log("invalid session file " + path);
+		return false;
+	}
+
+	//index the whole file up front so that frames can be streamed and accelerometer readings looked up by time
+	while (true)
+	{
+		char type;
+		long long timestamp;
+		ifs.read(&type, 1);
+		ifs.read((char*)&timestamp, sizeof(timestamp));
+
+		if (!ifs)
+			break;
+
+		if (type == SESSION_RECORD_FRAME)
+		{
+			SessionFrame frame;
+			frame.timestamp = timestamp;
+			ifs.read((char*)&frame.size, sizeof(frame.size));
+			frame.offset = ifs.tellg();
+			ifs.seekg(frame.size, ios::cur);
+
+			if (!ifs)
+				break;
+
+			frame_vec.push_back(frame);
+		}
+		else if (type == SESSION_RECORD_ACCELEROMETER)
+		{
+			int values[3];
+			ifs.read((char*)values, sizeof(values));
+
+			if (!ifs)
+				break;
+
+			SessionAccelerometerReading reading;
+			reading.timestamp = timestamp;
+			reading.x = values[0];
+			reading.y = values[1];
+			reading.z = values[2];
+			accelerometer_vec.push_back(reading);
+		}
+		else
+		{
+			console_log("corrupted session record, stopped indexing");
+			break;
+		}
+	}
+
+	ifs.clear();
+
+	console_log("session loaded: " + to_string(frame_vec.size()) + " frames, " +
+				to_string(accelerometer_vec.size()) + " accelerometer readings");
+
+	return frame_vec.size() > 0;
+}
+
+void SessionPlayer::play()
+{
+	vector<unsigned char> buffer;
+	const chrono::steady_clock::time_point time_start = chrono::steady_clock::now();
+
+	for (SessionFrame& frame : frame_vec)
+	{
+		if (realtime)
+			this_thread::sleep_until(time_start + chrono::microseconds(frame.timestamp - frame_vec[0].timestamp));
+		else
+			while (consumer_ready && !consumer_ready() && !stop_requested)
+				this_thread::sleep_for(chrono::microseconds(100));
+
+		if (stop_requested)
+			break;
+
+		if (buffer.size() < frame.size)
+			buffer.resize(frame.size);
+
+		ifs.seekg(frame.offset);
+		ifs.read((char*)&buffer[0], frame.size);
+
+		if (!ifs)
+			break;
+
+		++frame_count;
+
+		frame_callback(&buffer[0], frame.size, frame.timestamp);
+	}
+
+	is_finished = true;
+}
+
+bool SessionPlayer::start(function<void (unsigned char* data, unsigned long size, long long timestamp)> _frame_callback)
+{
+	if (!load())
+	{
+		is_finished = true;
+		return false;
+	}
+
+	frame_callback = _frame_callback;
+	player_thread = new thread(&SessionPlayer::play, this);
+
+	return true;
+}
+
+void SessionPlayer::stop()
+{
+	stop_requested = true;
+
+	if (player_thread != NULL)
+	{
+		if (player_thread->joinable())
+			player_thread->join();
+
+		delete player_thread;
+		player_thread = NULL;
+	}
+}
+
+bool SessionPlayer::finished()
+{
+	return is_finished;
+}
+
+int SessionPlayer::get_accelerometer_samples(const long long timestamp, AccelerometerSample* samples_out)
+{
+	if (accelerometer_vec.size() == 0)
+		return 0;
+
+	//readings are sampled independently of the frames, the history ends at the first one at or after the frame so that
+	//the IMU interpolates from the recorded readings only, whatever the tracking thread happens to be doing
+	auto it = lower_bound(accelerometer_vec.begin(), accelerometer_vec.end(), timestamp,
+						  [](const SessionAccelerometerReading& reading, const long long value)
+	{
+		return reading.timestamp < value;
+	});
+
+	if (it == accelerometer_vec.end())
+		--it;
+
+	const int index_last = it - accelerometer_vec.begin();
+	const int index_first = max(0, index_last - ACCELEROMETER_SAMPLE_HISTORY + 1);
+
+	for (int i = index_first; i <= index_last; ++i)
+	{
+		AccelerometerSample& sample = samples_out[i - index_first];
+		sample.timestamp = accelerometer_vec[i].timestamp;
+		sample.x = accelerometer_vec[i].x;
+		sample.y = accelerometer_vec[i].y;
+		sample.z = accelerometer_vec[i].z;
+	}
+
+	return index_last - index_first + 1;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "frame_source.h"
+#include "session_recorder.h"
+#include "globals.h"
+
+using namespace std;
+
+struct SessionFrame
+{
+	long long timestamp;
+	long long offset;
+	unsigned int size;
+};
+
+struct SessionAccelerometerReading
+{
+	long long timestamp;
+	int x;
+	int y;
+	int z;
+};
+
+class SessionPlayer : public FrameSource
+{
+public:
+	string path;
+	bool realtime;
+
+	ifstream ifs;
+
+	vector<SessionFrame> frame_vec;
+	vector<SessionAccelerometerReading> accelerometer_vec;
+
+	function<void (unsigned char* data, unsigned long size, long long timestamp)> frame_callback;
+
+	//when not playing in realtime, the next frame is held back until this returns true
+	function<bool ()> consumer_ready;
+
+	thread* player_thread = NULL;
+
+	atomic<bool> stop_requested;
+	atomic<bool> is_finished;
+
+	int frame_count = 0;
+
+	SessionPlayer(const string _path, bool _realtime);
+	~SessionPlayer();
+
+	bool load();
+	void play();
+
+	bool start(function<void (unsigned char* data, unsigned long size, long long timestamp)> _frame_callback);
+	void stop();
+	bool finished();
+	int get_accelerometer_samples(const long long timestamp, AccelerometerSample* samples_out);
+};
\ No newline at end of file
@@ -0,0 +1,87 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "session_recorder.h"
+#include "console_log.h"
+
+bool SessionRecorder::open(const string path)
+{
+	lock_guard<mutex> lock(ofs_mutex);
+
+	ofs.open(path, ios::binary | ios::trunc);
+	if (!ofs.is_open())
+	{
+		console_log("cannot open session file " + path);
+		return false;
+	}
+
+	const int version = SESSION_VERSION;
+	ofs.write(SESSION_MAGIC, 4);
+	ofs.write((char*)&version, sizeof(version));
+
+	time_start = chrono::steady_clock::now();
+
+	console_log("recording session to " + path);
+	return true;
+}
+
+void SessionRecorder::close()
+{
+	lock_guard<mutex> lock(ofs_mutex);
+
+	if (ofs.is_open())
+		ofs.close();
+}
+
+void SessionRecorder::write_frame(unsigned char* data, unsigned long size)
+{
+	const long long timestamp = get_timestamp();
+	const unsigned int size_u32 = size;
+	const char type = SESSION_RECORD_FRAME;
+
+	lock_guard<mutex> lock(ofs_mutex);
+
+	if (!ofs.is_open())
+		return;
+
+	ofs.write(&type, 1);
+	ofs.write((char*)&timestamp, sizeof(timestamp));
+	ofs.write((char*)&size_u32, sizeof(size_u32));
+	ofs.write((char*)data, size_u32);
+}
+
+void SessionRecorder::write_accelerometer(int x, int y, int z)
+{
+	const long long timestamp = get_timestamp();
+	const int values[3] = { x, y, z };
+	const char type = SESSION_RECORD_ACCELEROMETER;
+
+	lock_guard<mutex> lock(ofs_mutex);
+
+	if (!ofs.is_open())
+		return;
+
+	ofs.write(&type, 1);
+	ofs.write((char*)&timestamp, sizeof(timestamp));
+	ofs.write((char*)values, sizeof(values));
+}
+
+long long SessionRecorder::get_timestamp()
+{
+	return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - time_start).count();
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <mutex>
+#include <chrono>
+
+using namespace std;
+
+#define SESSION_MAGIC                "TPSR"
+#define SESSION_VERSION              1
+#define SESSION_RECORD_FRAME         'F'
+#define SESSION_RECORD_ACCELEROMETER 'A'
+
+//session file layout: magic, version, then a flat list of records
+//frame record:         type, timestamp (microseconds), size, raw MJPEG bytes
+//accelerometer record: type, timestamp (microseconds), x, y, z
+
+class SessionRecorder
+{
+public:
+	ofstream ofs;
+	mutex ofs_mutex;
+
+	chrono::steady_clock::time_point time_start;
+
+	bool open(const string path);
+	void close();
+	void write_frame(unsigned char* data, unsigned long size);
+	void write_accelerometer(int x, int y, int z);
+	long long get_timestamp();
+};
\ No newline at end of file
@@ -0,0 +1,1064 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#include "simd_functions.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__GNUC__)
+#define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_SSE2
+#define SIMD_TARGET_AVX2
+#endif
+
+SIMDKernels simd_kernels = get_simd_kernels(detect_simd_level());
+
+//------------------------------------------------scalar------------------------------------------------
+
+static void channel_diff_row_scalar(const uchar* row_bgr, uchar* row_out, const int width)
+{
+	for (int i = 0; i < width; ++i)
+	{
+		const uchar* pix = row_bgr + i * 3;
+		const int diff0 = max(pix[0] - pix[1], 0);
+		const int diff1 = max(pix[2] - pix[1], 0);
+		row_out[i] = min(diff0, diff1);
+	}
+}
+
+static void min_max_row_scalar(const uchar* row, const int width, uchar& gray_min, uchar& gray_max)
+{
+	uchar gray_min_current = gray_min;
+	uchar gray_max_current = gray_max;
+
+	for (int i = 0; i < width; ++i)
+	{
+		gray_min_current = min(gray_min_current, row[i]);
+		gray_max_current = max(gray_max_current, row[i]);
+	}
+
+	gray_min = gray_min_current;
+	gray_max = gray_max_current;
+}
+
+static void threshold_row_scalar(const uchar* row_in, uchar* row_out, const int width, const uchar threshold_val, const uchar gray,
+								 int& i_min, int& i_max)
+{
+	i_min = -1;
+	i_max = -1;
+
+	for (int i = 0; i < width; ++i)
+		if (row_in[i] > threshold_val)
+		{
+			row_out[i] = gray;
+
+			if (i_min == -1)
+				i_min = i;
+			i_max = i;
+		}
+		else
+			row_out[i] = 0;
+}
+
+static void max_channel_row_scalar(const uchar* row_bgr, uchar* row_out, const int width)
+{
+	for (int i = 0; i < width; ++i)
+	{
+		const uchar* pix = row_bgr + i * 3;
+		row_out[i] = max(pix[0], max(pix[1], pix[2]));
+	}
+}
+
+static void active_light_row_scalar(const uchar* row_bgr, const uchar* row_channel_diff, uchar* row_out, const int width)
+{
+	for (int i = 0; i < width; ++i)
+	{
+		const uchar* pix = row_bgr + i * 3;
+		const uchar gray0 = (pix[0] + pix[1] + pix[2]) / 3;
+
+		int gray_subtraction = abs(gray0 - row_channel_diff[i]);
+		if (gray_subtraction == 255)
+			gray_subtraction = 254;
+
+		row_out[i] = gray_subtraction;
+	}
+}
+
+static void motion_structure_row_scalar(const uchar* row_in, const uchar* row_old, uchar* row_out, const int width)
+{
+	for (int i = 0; i < width; ++i)
+	{
+		int diff = row_in[i] - row_old[i] + 127;
+		if (diff < 0)
+			diff = 0;
+		else if (diff > 254)
+			diff = 254;
+
+		row_out[i] = diff;
+	}
+}
+
+static void background_model_row_scalar(const uchar* row_in, const uchar* row_skip, ushort* row_mean, ushort* row_variance, ushort* row_count,
+										const int width, const short rate, const ushort lock_in, int& locked_count, int& deviating_count)
+{
+	for (int i = 0; i < width; ++i)
+	{
+		if (row_skip[i] > 0)
+			continue;
+
+		const int x = row_in[i] << 7;
+		if (row_count[i] == 0)
+		{
+			row_mean[i] = x;
+			row_variance[i] = BACKGROUND_MODEL_VARIANCE_INIT;
+			row_count[i] = 1;
+			continue;
+		}
+
+		const int diff = x - row_mean[i];
+		int dev = abs(diff) >> 7;
+		if (dev > BACKGROUND_MODEL_DEV_MAX)
+			dev = BACKGROUND_MODEL_DEV_MAX;
+
+		const int dev_sq = (dev * dev) << 4;
+		int variance_k = row_variance[i] * 6;
+		if (variance_k > 65535)
+			variance_k = 65535;
+
+		const bool locked = row_count[i] >= lock_in;
+		if (locked)
+			++locked_count;
+
+		if (dev > BACKGROUND_MODEL_DIFF_MIN && dev_sq > variance_k)
+		{
+			if (locked)
+				++deviating_count;
+			else
+			{
+				row_mean[i] = x;
+				row_variance[i] = BACKGROUND_MODEL_VARIANCE_INIT;
+				row_count[i] = 1;
+			}
+			continue;
+		}
+
+		//arithmetic shifts round toward -inf like _mm_mulhi_epi16
+		row_mean[i] += (diff * rate) >> 16;
+		row_variance[i] += ((dev_sq - row_variance[i]) * rate) >> 16;
+		if (row_count[i] < BACKGROUND_MODEL_COUNT_MAX)
+			++row_count[i];
+	}
+}
+
+//-------------------------------------------------SSE2-------------------------------------------------
+
+#if SIMD_X86
+//five rounds of byte unpacking turn 32 interleaved BGR pixels into 2 registers per channel
+static inline SIMD_TARGET_SSE2 void load_bgr_sse2(const uchar* row_bgr, __m128i* v)
+{
+	for (int k = 0; k < 6; ++k)
+		v[k] = _mm_loadu_si128((const __m128i*)(row_bgr + k * 16));
+
+	for (int round = 0; round < 5; ++round)
+	{
+		const __m128i v0 = _mm_unpacklo_epi8(v[0], v[3]);
+		const __m128i v1 = _mm_unpackhi_epi8(v[0], v[3]);
+		const __m128i v2 = _mm_unpacklo_epi8(v[1], v[4]);
+		const __m128i v3 = _mm_unpackhi_epi8(v[1], v[4]);
+		const __m128i v4 = _mm_unpacklo_epi8(v[2], v[5]);
+		const __m128i v5 = _mm_unpackhi_epi8(v[2], v[5]);
+
+		v[0] = v0;
+		v[1] = v1;
+		v[2] = v2;
+		v[3] = v3;
+		v[4] = v4;
+		v[5] = v5;
+	}
+}
+
+//floor(x / 3) for x up to 765, x * 43691 >> 17 is exact in that range
+static inline SIMD_TARGET_SSE2 __m128i div3_epu16_sse2(const __m128i x)
+{
+	return _mm_srli_epi16(_mm_mulhi_epu16(x, _mm_set1_epi16((short)43691)), 1);
+}
+
+static SIMD_TARGET_SSE2 void channel_diff_row_sse2(const uchar* row_bgr, uchar* row_out, const int width)
+{
+	int i = 0;
+	for (; i + 32 <= width; i += 32)
+	{
+		__m128i v[6];
+		load_bgr_sse2(row_bgr + i * 3, v);
+
+		for (int k = 0; k < 2; ++k)
+		{
+			const __m128i diff0 = _mm_subs_epu8(v[k], v[k + 2]);
+			const __m128i diff1 = _mm_subs_epu8(v[k + 4], v[k + 2]);
+			_mm_storeu_si128((__m128i*)(row_out + i + k * 16), _mm_min_epu8(diff0, diff1));
+		}
+	}
+
+	channel_diff_row_scalar(row_bgr + i * 3, row_out + i, width - i);
+}
+
+static SIMD_TARGET_SSE2 void min_max_row_sse2(const uchar* row, const int width, uchar& gray_min, uchar& gray_max)
+{
+	int i = 0;
+	if (width >= 16)
+	{
+		__m128i v_min = _mm_set1_epi8((char)gray_min);
+		__m128i v_max = _mm_set1_epi8((char)gray_max);
+
+		for (; i + 16 <= width; i += 16)
+		{
+			const __m128i v = _mm_loadu_si128((const __m128i*)(row + i));
+			v_min = _mm_min_epu8(v_min, v);
+			v_max = _mm_max_epu8(v_max, v);
+		}
+
+		uchar mins[16];
+		uchar maxs[16];
+		_mm_storeu_si128((__m128i*)mins, v_min);
+		_mm_storeu_si128((__m128i*)maxs, v_max);
+
+		min_max_row_scalar(mins, 16, gray_min, gray_max);
+		min_max_row_scalar(maxs, 16, gray_min, gray_max);
+	}
+
+	min_max_row_scalar(row + i, width - i, gray_min, gray_max);
+}
+
+static SIMD_TARGET_SSE2 void threshold_row_sse2(const uchar* row_in, uchar* row_out, const int width, const uchar threshold_val, const uchar gray,
+												int& i_min, int& i_max)
+{
+	int i = 0;
+	int i_min_current = -1;
+	int i_max_current = -1;
+
+	//x > threshold_val as max(x, threshold_val + 1) == x, nothing passes a threshold of 255
+	if (threshold_val < 255)
+	{
+		const __m128i v_threshold = _mm_set1_epi8((char)(threshold_val + 1));
+		const __m128i v_gray = _mm_set1_epi8((char)gray);
+
+		for (; i + 16 <= width; i += 16)
+		{
+			const __m128i v = _mm_loadu_si128((const __m128i*)(row_in + i));
+			const __m128i v_mask = _mm_cmpeq_epi8(_mm_max_epu8(v, v_threshold), v);
+			_mm_storeu_si128((__m128i*)(row_out + i), _mm_and_si128(v_mask, v_gray));
+
+			const int mask = _mm_movemask_epi8(v_mask);
+			if (mask != 0)
+			{
+				int k_min = 0;
+				while (!(mask & (1 << k_min)))
+					++k_min;
+
+				int k_max = 15;
+				while (!(mask & (1 << k_max)))
+					--k_max;
+
+				if (i_min_current == -1)
+					i_min_current = i + k_min;
+				i_max_current = i + k_max;
+			}
+		}
+	}
+
+	int i_min_rest;
+	int i_max_rest;
+	threshold_row_scalar(row_in + i, row_out + i, width - i, threshold_val, gray, i_min_rest, i_max_rest);
+
+	if (i_min_rest != -1)
+	{
+		if (i_min_current == -1)
+			i_min_current = i + i_min_rest;
+		i_max_current = i + i_max_rest;
+	}
+
+	i_min = i_min_current;
+	i_max = i_max_current;
+}
+
+static SIMD_TARGET_SSE2 void max_channel_row_sse2(const uchar* row_bgr, uchar* row_out, const int width)
+{
+	int i = 0;
+	for (; i + 32 <= width; i += 32)
+	{
+		__m128i v[6];
+		load_bgr_sse2(row_bgr + i * 3, v);
+
+		for (int k = 0; k < 2; ++k)
+			_mm_storeu_si128((__m128i*)(row_out + i + k * 16), _mm_max_epu8(v[k], _mm_max_epu8(v[k + 2], v[k + 4])));
+	}
+
+	max_channel_row_scalar(row_bgr + i * 3, row_out + i, width - i);
+}
+
+static SIMD_TARGET_SSE2 void active_light_row_sse2(const uchar* row_bgr, const uchar* row_channel_diff, uchar* row_out, const int width)
+{
+	const __m128i v_zero = _mm_setzero_si128();
+	const __m128i v_max = _mm_set1_epi8((char)254);
+
+	int i = 0;
+	for (; i + 32 <= width; i += 32)
+	{
+		__m128i v[6];
+		load_bgr_sse2(row_bgr + i * 3, v);
+
+		for (int k = 0; k < 2; ++k)
+		{
+			const __m128i sum_lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(v[k], v_zero), _mm_unpacklo_epi8(v[k + 2], v_zero)),
+												 _mm_unpacklo_epi8(v[k + 4], v_zero));
+			const __m128i sum_hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(v[k], v_zero), _mm_unpackhi_epi8(v[k + 2], v_zero)),
+												 _mm_unpackhi_epi8(v[k + 4], v_zero));
+
+			const __m128i gray0 = _mm_packus_epi16(div3_epu16_sse2(sum_lo), div3_epu16_sse2(sum_hi));
+			const __m128i gray1 = _mm_loadu_si128((const __m128i*)(row_channel_diff + i + k * 16));
+			const __m128i diff = _mm_or_si128(_mm_subs_epu8(gray0, gray1), _mm_subs_epu8(gray1, gray0));
+
+			_mm_storeu_si128((__m128i*)(row_out + i + k * 16), _mm_min_epu8(diff, v_max));
+		}
+	}
+
+	active_light_row_scalar(row_bgr + i * 3, row_channel_diff + i, row_out + i, width - i);
+}
+
+//in >= old: min(in - old + 127, 254), in < old: max(127 - (old - in), 0), one of the two differences is always 0
+static SIMD_TARGET_SSE2 void motion_structure_row_sse2(const uchar* row_in, const uchar* row_old, uchar* row_out, const int width)
+{
+	const __m128i v_mid = _mm_set1_epi8(127);
+	const __m128i v_max = _mm_set1_epi8((char)254);
+
+	int i = 0;
+	for (; i + 16 <= width; i += 16)
+	{
+		const __m128i v_in = _mm_loadu_si128((const __m128i*)(row_in + i));
+		const __m128i v_old = _mm_loadu_si128((const __m128i*)(row_old + i));
+		const __m128i diff_pos = _mm_subs_epu8(v_in, v_old);
+		const __m128i diff_neg = _mm_subs_epu8(v_old, v_in);
+
+		_mm_storeu_si128((__m128i*)(row_out + i), _mm_min_epu8(_mm_subs_epu8(_mm_adds_epu8(v_mid, diff_pos), diff_neg), v_max));
+	}
+
+	motion_structure_row_scalar(row_in + i, row_old + i, row_out + i, width - i);
+}
+
+//8 pixels per step in 16 bit lanes, the three outcomes (restart, learn, keep) are blended with masks
+static SIMD_TARGET_SSE2 void background_model_row_sse2(const uchar* row_in, const uchar* row_skip, ushort* row_mean, ushort* row_variance,
+													   ushort* row_count, const int width, const short rate, const ushort lock_in,
+													   int& locked_count, int& deviating_count)
+{
+	const __m128i v_zero = _mm_setzero_si128();
+	const __m128i v_one = _mm_set1_epi16(1);
+	const __m128i v_rate = _mm_set1_epi16(rate);
+	const __m128i v_lock_in = _mm_set1_epi16(lock_in - 1);
+	const __m128i v_variance_init = _mm_set1_epi16(BACKGROUND_MODEL_VARIANCE_INIT);
+	const __m128i v_dev_max = _mm_set1_epi16(BACKGROUND_MODEL_DEV_MAX);
+	const __m128i v_diff_min = _mm_set1_epi16(BACKGROUND_MODEL_DIFF_MIN);
+	const __m128i v_count_max = _mm_set1_epi16(BACKGROUND_MODEL_COUNT_MAX);
+
+	//lanes hold -1 per hit, summed once at the end of the row
+	__m128i v_locked_count = v_zero;
+	__m128i v_deviating_count = v_zero;
+
+	int i = 0;
+	for (; i + 8 <= width; i += 8)
+	{
+		const __m128i v_x = _mm_slli_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row_in + i)), v_zero), 7);
+		const __m128i v_update = _mm_cmpeq_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row_skip + i)), v_zero), v_zero);
+
+		const __m128i v_mean = _mm_loadu_si128((const __m128i*)(row_mean + i));
+		const __m128i v_variance = _mm_loadu_si128((const __m128i*)(row_variance + i));
+		const __m128i v_count = _mm_loadu_si128((const __m128i*)(row_count + i));
+
+		const __m128i v_new = _mm_cmpeq_epi16(v_count, v_zero);
+		const __m128i v_locked = _mm_cmpgt_epi16(v_count, v_lock_in);
+
+		const __m128i v_diff = _mm_sub_epi16(v_x, v_mean);
+		const __m128i v_diff_abs = _mm_max_epi16(v_diff, _mm_sub_epi16(v_zero, v_diff));
+		const __m128i v_dev = _mm_min_epi16(_mm_srli_epi16(v_diff_abs, 7), v_dev_max);
+		const __m128i v_dev_sq = _mm_slli_epi16(_mm_mullo_epi16(v_dev, v_dev), 4);
+
+		const __m128i v_variance_2 = _mm_adds_epu16(v_variance, v_variance);
+		const __m128i v_variance_k = _mm_adds_epu16(_mm_adds_epu16(v_variance_2, v_variance_2), v_variance_2);
+		const __m128i v_dev_sq_small = _mm_cmpeq_epi16(_mm_subs_epu16(v_dev_sq, v_variance_k), v_zero);
+		const __m128i v_deviating = _mm_andnot_si128(v_dev_sq_small, _mm_cmpgt_epi16(v_dev, v_diff_min));
+
+		const __m128i v_active = _mm_andnot_si128(v_new, v_update);
+		const __m128i v_active_locked = _mm_and_si128(v_active, v_locked);
+		v_locked_count = _mm_add_epi16(v_locked_count, v_active_locked);
+		v_deviating_count = _mm_add_epi16(v_deviating_count, _mm_and_si128(v_active_locked, v_deviating));
+
+		const __m128i v_restart = _mm_and_si128(v_update, _mm_or_si128(v_new, _mm_andnot_si128(v_locked, v_deviating)));
+		const __m128i v_learn = _mm_andnot_si128(v_deviating, v_active);
+		const __m128i v_keep = _mm_andnot_si128(_mm_or_si128(v_restart, v_learn), _mm_set1_epi16(-1));
+
+		const __m128i v_mean_learn = _mm_add_epi16(v_mean, _mm_mulhi_epi16(v_diff, v_rate));
+		const __m128i v_variance_learn = _mm_add_epi16(v_variance, _mm_mulhi_epi16(_mm_sub_epi16(v_dev_sq, v_variance), v_rate));
+		const __m128i v_count_learn = _mm_min_epi16(_mm_add_epi16(v_count, v_one), v_count_max);
+
+		const __m128i v_mean_out = _mm_or_si128(_mm_or_si128(_mm_and_si128(v_restart, v_x), _mm_and_si128(v_learn, v_mean_learn)),
+												_mm_and_si128(v_keep, v_mean));
+		const __m128i v_variance_out = _mm_or_si128(_mm_or_si128(_mm_and_si128(v_restart, v_variance_init),
+																 _mm_and_si128(v_learn, v_variance_learn)),
+													_mm_and_si128(v_keep, v_variance));
+		const __m128i v_count_out = _mm_or_si128(_mm_or_si128(_mm_and_si128(v_restart, v_one), _mm_and_si128(v_learn, v_count_learn)),
+												 _mm_and_si128(v_keep, v_count));
+
+		_mm_storeu_si128((__m128i*)(row_mean + i), v_mean_out);
+		_mm_storeu_si128((__m128i*)(row_variance + i), v_variance_out);
+		_mm_storeu_si128((__m128i*)(row_count + i), v_count_out);
+	}
+
+	short locked_lanes[8];
+	short deviating_lanes[8];
+	_mm_storeu_si128((__m128i*)locked_lanes, v_locked_count);
+	_mm_storeu_si128((__m128i*)deviating_lanes, v_deviating_count);
+	for (int k = 0; k < 8; ++k)
+	{
+		locked_count -= locked_lanes[k];
+		deviating_count -= deviating_lanes[k];
+	}
+
+	background_model_row_scalar(row_in + i, row_skip + i, row_mean + i, row_variance + i, row_count + i, width - i,
+								rate, lock_in, locked_count, deviating_count);
+}
+
+//-------------------------------------------------AVX2-------------------------------------------------
+
+//same network as load_bgr_sse2, each 128 bit lane deinterleaves its own block of 32 pixels
+static inline SIMD_TARGET_AVX2 void load_bgr_avx2(const uchar* row_bgr, __m256i* v)
+{
+	for (int k = 0; k < 6; ++k)
+		v[k] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(row_bgr + k * 16))),
+									   _mm_loadu_si128((const __m128i*)(row_bgr + 96 + k * 16)), 1);
+
+	for (int round = 0; round < 5; ++round)
+	{
+		const __m256i v0 = _mm256_unpacklo_epi8(v[0], v[3]);
+		const __m256i v1 = _mm256_unpackhi_epi8(v[0], v[3]);
+		const __m256i v2 = _mm256_unpacklo_epi8(v[1], v[4]);
+		const __m256i v3 = _mm256_unpackhi_epi8(v[1], v[4]);
+		const __m256i v4 = _mm256_unpacklo_epi8(v[2], v[5]);
+		const __m256i v5 = _mm256_unpackhi_epi8(v[2], v[5]);
+
+		v[0] = v0;
+		v[1] = v1;
+		v[2] = v2;
+		v[3] = v3;
+		v[4] = v4;
+		v[5] = v5;
+	}
+}
+
+//lane 0 holds pixels 0..15 of the first block, lane 1 the same pixels of the second block 32 pixels later
+static inline SIMD_TARGET_AVX2 void store_bgr_result_avx2(uchar* row_out, const int k, const __m256i v)
+{
+	_mm_storeu_si128((__m128i*)(row_out + k * 16), _mm256_castsi256_si128(v));
+	_mm_storeu_si128((__m128i*)(row_out + 32 + k * 16), _mm256_extracti128_si256(v, 1));
+}
+
+static SIMD_TARGET_AVX2 void channel_diff_row_avx2(const uchar* row_bgr, uchar* row_out, const int width)
+{
+	int i = 0;
+	for (; i + 64 <= width; i += 64)
+	{
+		__m256i v[6];
+		load_bgr_avx2(row_bgr + i * 3, v);
+
+		for (int k = 0; k < 2; ++k)
+		{
+			const __m256i diff0 = _mm256_subs_epu8(v[k], v[k + 2]);
+			const __m256i diff1 = _mm256_subs_epu8(v[k + 4], v[k + 2]);
+			store_bgr_result_avx2(row_out + i, k, _mm256_min_epu8(diff0, diff1));
+		}
+	}
+
+	channel_diff_row_sse2(row_bgr + i * 3, row_out + i, width - i);
+}
+
+static SIMD_TARGET_AVX2 void min_max_row_avx2(const uchar* row, const int width, uchar& gray_min, uchar& gray_max)
+{
+	int i = 0;
+	if (width >= 32)
+	{
+		__m256i v_min = _mm256_set1_epi8((char)gray_min);
+		__m256i v_max = _mm256_set1_epi8((char)gray_max);
+
+		for (; i + 32 <= width; i += 32)
+		{
+			const __m256i v = _mm256_loadu_si256((const __m256i*)(row + i));
+			v_min = _mm256_min_epu8(v_min, v);
+			v_max = _mm256_max_epu8(v_max, v);
+		}
+
+		uchar mins[32];
+		uchar maxs[32];
+		_mm256_storeu_si256((__m256i*)mins, v_min);
+		_mm256_storeu_si256((__m256i*)maxs, v_max);
+
+		min_max_row_scalar(mins, 32, gray_min, gray_max);
+		min_max_row_scalar(maxs, 32, gray_min, gray_max);
+	}
+
+	min_max_row_sse2(row + i, width - i, gray_min, gray_max);
+}
+
+static SIMD_TARGET_AVX2 void threshold_row_avx2(const uchar* row_in, uchar* row_out, const int width, const uchar threshold_val, const uchar gray,
+												int& i_min, int& i_max)
+{
+	int i = 0;
+	int i_min_current = -1;
+	int i_max_current = -1;
+
+	if (threshold_val < 255)
+	{
+		const __m256i v_threshold = _mm256_set1_epi8((char)(threshold_val + 1));
+		const __m256i v_gray = _mm256_set1_epi8((char)gray);
+
+		for (; i + 32 <= width; i += 32)
+		{
+			const __m256i v = _mm256_loadu_si256((const __m256i*)(row_in + i));
+			const __m256i v_mask = _mm256_cmpeq_epi8(_mm256_max_epu8(v, v_threshold), v);
+			_mm256_storeu_si256((__m256i*)(row_out + i), _mm256_and_si256(v_mask, v_gray));
+
+			const unsigned int mask = _mm256_movemask_epi8(v_mask);
+			if (mask != 0)
+			{
+				int k_min = 0;
+				while (!(mask & (1u << k_min)))
+					++k_min;
+
+				int k_max = 31;
+				while (!(mask & (1u << k_max)))
+					--k_max;
+
+				if (i_min_current == -1)
+					i_min_current = i + k_min;
+				i_max_current = i + k_max;
+			}
+		}
+	}
+
+	int i_min_rest;
+	int i_max_rest;
+	threshold_row_sse2(row_in + i, row_out + i, width - i, threshold_val, gray, i_min_rest, i_max_rest);
+
+	if (i_min_rest != -1)
+	{
+		if (i_min_current == -1)
+			i_min_current = i + i_min_rest;
+		i_max_current = i + i_max_rest;
+	}
+
+	i_min = i_min_current;
+	i_max = i_max_current;
+}
+
+static SIMD_TARGET_AVX2 void max_channel_row_avx2(const uchar* row_bgr, uchar* row_out, const int width)
+{
+	int i = 0;
+	for (; i + 64 <= width; i += 64)
+	{
+		__m256i v[6];
+		load_bgr_avx2(row_bgr + i * 3, v);
+
+		for (int k = 0; k < 2; ++k)
+			store_bgr_result_avx2(row_out + i, k, _mm256_max_epu8(v[k], _mm256_max_epu8(v[k + 2], v[k + 4])));
+	}
+
+	max_channel_row_sse2(row_bgr + i * 3, row_out + i, width - i);
+}
+
+static SIMD_TARGET_AVX2 void active_light_row_avx2(const uchar* row_bgr, const uchar* row_channel_diff, uchar* row_out, const int width)
+{
+	const __m256i v_zero = _mm256_setzero_si256();
+	const __m256i v_max = _mm256_set1_epi8((char)254);
+	const __m256i v_div3 = _mm256_set1_epi16((short)43691);
+
+	int i = 0;
+	for (; i + 64 <= width; i += 64)
+	{
+		__m256i v[6];
+		load_bgr_avx2(row_bgr + i * 3, v);
+
+		for (int k = 0; k < 2; ++k)
+		{
+			//unpack and pack both stay within lanes, so the pixel order of each lane is kept
+			const __m256i sum_lo = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(v[k], v_zero), _mm256_unpacklo_epi8(v[k + 2], v_zero)),
+													_mm256_unpacklo_epi8(v[k + 4], v_zero));
+			const __m256i sum_hi = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(v[k], v_zero), _mm256_unpackhi_epi8(v[k + 2], v_zero)),
+													_mm256_unpackhi_epi8(v[k + 4], v_zero));
+
+			const __m256i gray0 = _mm256_packus_epi16(_mm256_srli_epi16(_mm256_mulhi_epu16(sum_lo, v_div3), 1),
+													  _mm256_srli_epi16(_mm256_mulhi_epu16(sum_hi, v_div3), 1));
+
+			const __m256i gray1 = _mm256_inserti128_si256(
+				_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(row_channel_diff + i + k * 16))),
+				_mm_loadu_si128((const __m128i*)(row_channel_diff + i + 32 + k * 16)), 1);
+
+			const __m256i diff = _mm256_or_si256(_mm256_subs_epu8(gray0, gray1), _mm256_subs_epu8(gray1, gray0));
+			store_bgr_result_avx2(row_out + i, k, _mm256_min_epu8(diff, v_max));
+		}
+	}
+
+	active_light_row_sse2(row_bgr + i * 3, row_channel_diff + i, row_out + i, width - i);
+}
+
+static SIMD_TARGET_AVX2 void motion_structure_row_avx2(const uchar* row_in, const uchar* row_old, uchar* row_out, const int width)
+{
+	const __m256i v_mid = _mm256_set1_epi8(127);
+	const __m256i v_max = _mm256_set1_epi8((char)254);
+
+	int i = 0;
+	for (; i + 32 <= width; i += 32)
+	{
+		const __m256i v_in = _mm256_loadu_si256((const __m256i*)(row_in + i));
+		const __m256i v_old = _mm256_loadu_si256((const __m256i*)(row_old + i));
+		const __m256i diff_pos = _mm256_subs_epu8(v_in, v_old);
+		const __m256i diff_neg = _mm256_subs_epu8(v_old, v_in);
+
+		_mm256_storeu_si256((__m256i*)(row_out + i),
+							_mm256_min_epu8(_mm256_subs_epu8(_mm256_adds_epu8(v_mid, diff_pos), diff_neg), v_max));
+	}
+
+	motion_structure_row_sse2(row_in + i, row_old + i, row_out + i, width - i);
+}
+static SIMD_TARGET_AVX2 void background_model_row_avx2(const uchar* row_in, const uchar* row_skip, ushort* row_mean, ushort* row_variance,
+													   ushort* row_count, const int width, const short rate, const ushort lock_in,
+													   int& locked_count, int& deviating_count)
+{
+	const __m256i v_zero = _mm256_setzero_si256();
+	const __m256i v_one = _mm256_set1_epi16(1);
+	const __m256i v_rate = _mm256_set1_epi16(rate);
+	const __m256i v_lock_in = _mm256_set1_epi16(lock_in - 1);
+	const __m256i v_variance_init = _mm256_set1_epi16(BACKGROUND_MODEL_VARIANCE_INIT);
+	const __m256i v_dev_max = _mm256_set1_epi16(BACKGROUND_MODEL_DEV_MAX);
+	const __m256i v_diff_min = _mm256_set1_epi16(BACKGROUND_MODEL_DIFF_MIN);
+	const __m256i v_count_max = _mm256_set1_epi16(BACKGROUND_MODEL_COUNT_MAX);
+
+	__m256i v_locked_count = v_zero;
+	__m256i v_deviating_count = v_zero;
+
+	int i = 0;
+	for (; i + 16 <= width; i += 16)
+	{
+		const __m256i v_x = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(row_in + i))), 7);
+		const __m256i v_update = _mm256_cmpeq_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(row_skip + i))), v_zero);
+
+		const __m256i v_mean = _mm256_loadu_si256((const __m256i*)(row_mean + i));
+		const __m256i v_variance = _mm256_loadu_si256((const __m256i*)(row_variance + i));
+		const __m256i v_count = _mm256_loadu_si256((const __m256i*)(row_count + i));
+
+		const __m256i v_new = _mm256_cmpeq_epi16(v_count, v_zero);
+		const __m256i v_locked = _mm256_cmpgt_epi16(v_count, v_lock_in);
+
+		const __m256i v_diff = _mm256_sub_epi16(v_x, v_mean);
+		const __m256i v_dev = _mm256_min_epi16(_mm256_srli_epi16(_mm256_abs_epi16(v_diff), 7), v_dev_max);
+		const __m256i v_dev_sq = _mm256_slli_epi16(_mm256_mullo_epi16(v_dev, v_dev), 4);
+
+		const __m256i v_variance_2 = _mm256_adds_epu16(v_variance, v_variance);
+		const __m256i v_variance_k = _mm256_adds_epu16(_mm256_adds_epu16(v_variance_2, v_variance_2), v_variance_2);
+		const __m256i v_dev_sq_small = _mm256_cmpeq_epi16(_mm256_subs_epu16(v_dev_sq, v_variance_k), v_zero);
+		const __m256i v_deviating = _mm256_andnot_si256(v_dev_sq_small, _mm256_cmpgt_epi16(v_dev, v_diff_min));
+
+		const __m256i v_active = _mm256_andnot_si256(v_new, v_update);
+		const __m256i v_active_locked = _mm256_and_si256(v_active, v_locked);
+		v_locked_count = _mm256_add_epi16(v_locked_count, v_active_locked);
+		v_deviating_count = _mm256_add_epi16(v_deviating_count, _mm256_and_si256(v_active_locked, v_deviating));
+
+		const __m256i v_restart = _mm256_and_si256(v_update, _mm256_or_si256(v_new, _mm256_andnot_si256(v_locked, v_deviating)));
+		const __m256i v_learn = _mm256_andnot_si256(v_deviating, v_active);
+
+		const __m256i v_mean_learn = _mm256_add_epi16(v_mean, _mm256_mulhi_epi16(v_diff, v_rate));
+		const __m256i v_variance_learn = _mm256_add_epi16(v_variance, _mm256_mulhi_epi16(_mm256_sub_epi16(v_dev_sq, v_variance), v_rate));
+		const __m256i v_count_learn = _mm256_min_epi16(_mm256_add_epi16(v_count, v_one), v_count_max);
+
+		const __m256i v_mean_out = _mm256_blendv_epi8(_mm256_blendv_epi8(v_mean, v_mean_learn, v_learn), v_x, v_restart);
+		const __m256i v_variance_out = _mm256_blendv_epi8(_mm256_blendv_epi8(v_variance, v_variance_learn, v_learn), v_variance_init, v_restart);
+		const __m256i v_count_out = _mm256_blendv_epi8(_mm256_blendv_epi8(v_count, v_count_learn, v_learn), v_one, v_restart);
+
+		_mm256_storeu_si256((__m256i*)(row_mean + i), v_mean_out);
+		_mm256_storeu_si256((__m256i*)(row_variance + i), v_variance_out);
+		_mm256_storeu_si256((__m256i*)(row_count + i), v_count_out);
+	}
+
+	short locked_lanes[16];
+	short deviating_lanes[16];
+	_mm256_storeu_si256((__m256i*)locked_lanes, v_locked_count);
+	_mm256_storeu_si256((__m256i*)deviating_lanes, v_deviating_count);
+	for (int k = 0; k < 16; ++k)
+	{
+		locked_count -= locked_lanes[k];
+		deviating_count -= deviating_lanes[k];
+	}
+
+	background_model_row_sse2(row_in + i, row_skip + i, row_mean + i, row_variance + i, row_count + i, width - i,
+							  rate, lock_in, locked_count, deviating_count);
+}
+#endif
+
+//-------------------------------------------------NEON-------------------------------------------------
+
+#if SIMD_NEON
+static void channel_diff_row_neon(const uchar* row_bgr, uchar* row_out, const int width)
+{
+	int i = 0;
+	for (; i + 16 <= width; i += 16)
+	{
+		const uint8x16x3_t v = vld3q_u8(row_bgr + i * 3);
+		vst1q_u8(row_out + i, vminq_u8(vqsubq_u8(v.val[0], v.val[1]), vqsubq_u8(v.val[2], v.val[1])));
+	}
+
+	channel_diff_row_scalar(row_bgr + i * 3, row_out + i, width - i);
+}
+
+static void min_max_row_neon(const uchar* row, const int width, uchar& gray_min, uchar& gray_max)
+{
+	int i = 0;
+	if (width >= 16)
+	{
+		uint8x16_t v_min = vdupq_n_u8(gray_min);
+		uint8x16_t v_max = vdupq_n_u8(gray_max);
+
+		for (; i + 16 <= width; i += 16)
+		{
+			const uint8x16_t v = vld1q_u8(row + i);
+			v_min = vminq_u8(v_min, v);
+			v_max = vmaxq_u8(v_max, v);
+		}
+
+		uchar mins[16];
+		uchar maxs[16];
+		vst1q_u8(mins, v_min);
+		vst1q_u8(maxs, v_max);
+
+		min_max_row_scalar(mins, 16, gray_min, gray_max);
+		min_max_row_scalar(maxs, 16, gray_min, gray_max);
+	}
+
+	min_max_row_scalar(row + i, width - i, gray_min, gray_max);
+}
+
+static void threshold_row_neon(const uchar* row_in, uchar* row_out, const int width, const uchar threshold_val, const uchar gray,
+							   int& i_min, int& i_max)
+{
+	int i = 0;
+	int i_min_current = -1;
+	int i_max_current = -1;
+
+	const uint8x16_t v_threshold = vdupq_n_u8(threshold_val);
+	const uint8x16_t v_gray = vdupq_n_u8(gray);
+
+	for (; i + 16 <= width; i += 16)
+	{
+		const uint8x16_t v_mask = vcgtq_u8(vld1q_u8(row_in + i), v_threshold);
+		vst1q_u8(row_out + i, vandq_u8(v_mask, v_gray));
+
+		uchar mask[16];
+		vst1q_u8(mask, v_mask);
+
+		for (int k = 0; k < 16; ++k)
+			if (mask[k])
+			{
+				if (i_min_current == -1)
+					i_min_current = i + k;
+				i_max_current = i + k;
+			}
+	}
+
+	int i_min_rest;
+	int i_max_rest;
+	threshold_row_scalar(row_in + i, row_out + i, width - i, threshold_val, gray, i_min_rest, i_max_rest);
+
+	if (i_min_rest != -1)
+	{
+		if (i_min_current == -1)
+			i_min_current = i + i_min_rest;
+		i_max_current = i + i_max_rest;
+	}
+
+	i_min = i_min_current;
+	i_max = i_max_current;
+}
+
+static void max_channel_row_neon(const uchar* row_bgr, uchar* row_out, const int width)
+{
+	int i = 0;
+	for (; i + 16 <= width; i += 16)
+	{
+		const uint8x16x3_t v = vld3q_u8(row_bgr + i * 3);
+		vst1q_u8(row_out + i, vmaxq_u8(v.val[0], vmaxq_u8(v.val[1], v.val[2])));
+	}
+
+	max_channel_row_scalar(row_bgr + i * 3, row_out + i, width - i);
+}
+
+static void active_light_row_neon(const uchar* row_bgr, const uchar* row_channel_diff, uchar* row_out, const int width)
+{
+	const uint16x4_t v_div3 = vdup_n_u16(43691);
+	const uint8x16_t v_max = vdupq_n_u8(254);
+
+	int i = 0;
+	for (; i + 16 <= width; i += 16)
+	{
+		const uint8x16x3_t v = vld3q_u8(row_bgr + i * 3);
+
+		const uint16x8_t sum_lo = vaddw_u8(vaddl_u8(vget_low_u8(v.val[0]), vget_low_u8(v.val[1])), vget_low_u8(v.val[2]));
+		const uint16x8_t sum_hi = vaddw_u8(vaddl_u8(vget_high_u8(v.val[0]), vget_high_u8(v.val[1])), vget_high_u8(v.val[2]));
+
+		const uint16x8_t gray_lo = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(sum_lo), v_div3), 16),
+												vshrn_n_u32(vmull_u16(vget_high_u16(sum_lo), v_div3), 16));
+		const uint16x8_t gray_hi = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(sum_hi), v_div3), 16),
+												vshrn_n_u32(vmull_u16(vget_high_u16(sum_hi), v_div3), 16));
+
+		const uint8x16_t gray0 = vcombine_u8(vshrn_n_u16(gray_lo, 1), vshrn_n_u16(gray_hi, 1));
+		const uint8x16_t gray1 = vld1q_u8(row_channel_diff + i);
+
+		vst1q_u8(row_out + i, vminq_u8(vabdq_u8(gray0, gray1), v_max));
+	}
+
+	active_light_row_scalar(row_bgr + i * 3, row_channel_diff + i, row_out + i, width - i);
+}
+
+static void motion_structure_row_neon(const uchar* row_in, const uchar* row_old, uchar* row_out, const int width)
+{
+	const uint8x16_t v_mid = vdupq_n_u8(127);
+	const uint8x16_t v_max = vdupq_n_u8(254);
+
+	int i = 0;
+	for (; i + 16 <= width; i += 16)
+	{
+		const uint8x16_t v_in = vld1q_u8(row_in + i);
+		const uint8x16_t v_old = vld1q_u8(row_old + i);
+
+		vst1q_u8(row_out + i, vminq_u8(vqsubq_u8(vqaddq_u8(v_mid, vqsubq_u8(v_in, v_old)), vqsubq_u8(v_old, v_in)), v_max));
+	}
+
+	motion_structure_row_scalar(row_in + i, row_old + i, row_out + i, width - i);
+}
+static void background_model_row_neon(const uchar* row_in, const uchar* row_skip, ushort* row_mean, ushort* row_variance, ushort* row_count,
+									  const int width, const short rate, const ushort lock_in, int& locked_count, int& deviating_count)
+{
+	const int16x8_t v_zero = vdupq_n_s16(0);
+	const int16x8_t v_one = vdupq_n_s16(1);
+	const int16x4_t v_rate = vdup_n_s16(rate);
+	const int16x8_t v_lock_in = vdupq_n_s16(lock_in - 1);
+	const int16x8_t v_variance_init = vdupq_n_s16(BACKGROUND_MODEL_VARIANCE_INIT);
+	const int16x8_t v_dev_max = vdupq_n_s16(BACKGROUND_MODEL_DEV_MAX);
+	const int16x8_t v_diff_min = vdupq_n_s16(BACKGROUND_MODEL_DIFF_MIN);
+	const int16x8_t v_count_max = vdupq_n_s16(BACKGROUND_MODEL_COUNT_MAX);
+
+	uint16x8_t v_locked_count = vdupq_n_u16(0);
+	uint16x8_t v_deviating_count = vdupq_n_u16(0);
+
+	int i = 0;
+	for (; i + 8 <= width; i += 8)
+	{
+		const int16x8_t v_x = vreinterpretq_s16_u16(vshlq_n_u16(vmovl_u8(vld1_u8(row_in + i)), 7));
+		const uint16x8_t v_update = vceqq_u16(vmovl_u8(vld1_u8(row_skip + i)), vdupq_n_u16(0));
+
+		const int16x8_t v_mean = vreinterpretq_s16_u16(vld1q_u16(row_mean + i));
+		const int16x8_t v_variance = vreinterpretq_s16_u16(vld1q_u16(row_variance + i));
+		const int16x8_t v_count = vreinterpretq_s16_u16(vld1q_u16(row_count + i));
+
+		const uint16x8_t v_new = vceqq_s16(v_count, v_zero);
+		const uint16x8_t v_locked = vcgtq_s16(v_count, v_lock_in);
+
+		const int16x8_t v_diff = vsubq_s16(v_x, v_mean);
+		const int16x8_t v_dev = vminq_s16(vshrq_n_s16(vabsq_s16(v_diff), 7), v_dev_max);
+		const int16x8_t v_dev_sq = vshlq_n_s16(vmulq_s16(v_dev, v_dev), 4);
+
+		const uint16x8_t v_variance_2 = vqaddq_u16(vreinterpretq_u16_s16(v_variance), vreinterpretq_u16_s16(v_variance));
+		const uint16x8_t v_variance_k = vqaddq_u16(vqaddq_u16(v_variance_2, v_variance_2), v_variance_2);
+		const uint16x8_t v_deviating = vandq_u16(vcgtq_u16(vreinterpretq_u16_s16(v_dev_sq), v_variance_k), vcgtq_s16(v_dev, v_diff_min));
+
+		const uint16x8_t v_active = vbicq_u16(v_update, v_new);
+		const uint16x8_t v_active_locked = vandq_u16(v_active, v_locked);
+		v_locked_count = vsubq_u16(v_locked_count, v_active_locked);
+		v_deviating_count = vsubq_u16(v_deviating_count, vandq_u16(v_active_locked, v_deviating));
+
+		const uint16x8_t v_restart = vandq_u16(v_update, vorrq_u16(v_new, vbicq_u16(v_deviating, v_locked)));
+		const uint16x8_t v_learn = vbicq_u16(v_active, v_deviating);
+
+		//(a * b) >> 16 like _mm_mulhi_epi16
+		const int16x8_t v_diff_rated = vcombine_s16(vshrn_n_s32(vmull_s16(vget_low_s16(v_diff), v_rate), 16),
+													vshrn_n_s32(vmull_s16(vget_high_s16(v_diff), v_rate), 16));
+		const int16x8_t v_variance_diff = vsubq_s16(v_dev_sq, v_variance);
+		const int16x8_t v_variance_rated = vcombine_s16(vshrn_n_s32(vmull_s16(vget_low_s16(v_variance_diff), v_rate), 16),
+														vshrn_n_s32(vmull_s16(vget_high_s16(v_variance_diff), v_rate), 16));
+
+		const int16x8_t v_mean_learn = vaddq_s16(v_mean, v_diff_rated);
+		const int16x8_t v_variance_learn = vaddq_s16(v_variance, v_variance_rated);
+		const int16x8_t v_count_learn = vminq_s16(vaddq_s16(v_count, v_one), v_count_max);
+
+		const int16x8_t v_mean_out = vbslq_s16(v_restart, v_x, vbslq_s16(v_learn, v_mean_learn, v_mean));
+		const int16x8_t v_variance_out = vbslq_s16(v_restart, v_variance_init, vbslq_s16(v_learn, v_variance_learn, v_variance));
+		const int16x8_t v_count_out = vbslq_s16(v_restart, v_one, vbslq_s16(v_learn, v_count_learn, v_count));
+
+		vst1q_u16(row_mean + i, vreinterpretq_u16_s16(v_mean_out));
+		vst1q_u16(row_variance + i, vreinterpretq_u16_s16(v_variance_out));
+		vst1q_u16(row_count + i, vreinterpretq_u16_s16(v_count_out));
+	}
+
+	ushort locked_lanes[8];
+	ushort deviating_lanes[8];
+	vst1q_u16(locked_lanes, v_locked_count);
+	vst1q_u16(deviating_lanes, v_deviating_count);
+	for (int k = 0; k < 8; ++k)
+	{
+		locked_count += locked_lanes[k];
+		deviating_count += deviating_lanes[k];
+	}
+
+	background_model_row_scalar(row_in + i, row_skip + i, row_mean + i, row_variance + i, row_count + i, width - i,
+								rate, lock_in, locked_count, deviating_count);
+}
+#endif
+
+//-----------------------------------------------dispatch-----------------------------------------------
+
+SIMDLevel detect_simd_level()
+{
+#if SIMD_NEON
+	return SIMD_LEVEL_NEON;
+#elif SIMD_X86
+	int info[4] = { 0, 0, 0, 0 };
+	int info_extended[4] = { 0, 0, 0, 0 };
+	unsigned long long xcr0 = 0;
+
+#ifdef _MSC_VER
+	__cpuid(info, 1);
+	__cpuidex(info_extended, 7, 0);
+	const bool os_saves_ymm = (info[2] & (1 << 27)) != 0;
+	if (os_saves_ymm)
+		xcr0 = _xgetbv(0);
+#else
+	__asm__ __volatile__("cpuid" : "=a"(info[0]), "=b"(info[1]), "=c"(info[2]), "=d"(info[3]) : "a"(1), "c"(0));
+	__asm__ __volatile__("cpuid" : "=a"(info_extended[0]), "=b"(info_extended[1]), "=c"(info_extended[2]), "=d"(info_extended[3]) : "a"(7), "c"(0));
+	const bool os_saves_ymm = (info[2] & (1 << 27)) != 0;
+	if (os_saves_ymm)
+	{
+		unsigned int eax;
+		unsigned int edx;
+		__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		xcr0 = ((unsigned long long)edx << 32) | eax;
+	}
+#endif
+
+	const bool has_sse2 = (info[3] & (1 << 26)) != 0;
+	const bool has_avx = (info[2] & (1 << 28)) != 0;
+	const bool has_avx2 = (info_extended[1] & (1 << 5)) != 0;
+
+	if (has_avx && has_avx2 && os_saves_ymm && (xcr0 & 6) == 6)
+		return SIMD_LEVEL_AVX2;
+	if (has_sse2)
+		return SIMD_LEVEL_SSE2;
+
+	return SIMD_LEVEL_SCALAR;
+#else
+	return SIMD_LEVEL_SCALAR;
+#endif
+}
+
+SIMDKernels get_simd_kernels(const SIMDLevel level)
+{
+	SIMDKernels kernels;
+	kernels.level = SIMD_LEVEL_SCALAR;
+	kernels.channel_diff_row = channel_diff_row_scalar;
+	kernels.min_max_row = min_max_row_scalar;
+	kernels.threshold_row = threshold_row_scalar;
+	kernels.max_channel_row = max_channel_row_scalar;
+	kernels.active_light_row = active_light_row_scalar;
+	kernels.motion_structure_row = motion_structure_row_scalar;
+	kernels.background_model_row = background_model_row_scalar;
+
+#if SIMD_X86
+	if (level == SIMD_LEVEL_SSE2)
+	{
+		kernels.level = SIMD_LEVEL_SSE2;
+		kernels.channel_diff_row = channel_diff_row_sse2;
+		kernels.min_max_row = min_max_row_sse2;
+		kernels.threshold_row = threshold_row_sse2;
+		kernels.max_channel_row = max_channel_row_sse2;
+		kernels.active_light_row = active_light_row_sse2;
+		kernels.motion_structure_row = motion_structure_row_sse2;
+		kernels.background_model_row = background_model_row_sse2;
+	}
+	else if (level == SIMD_LEVEL_AVX2)
+	{
+		kernels.level = SIMD_LEVEL_AVX2;
+		kernels.channel_diff_row = channel_diff_row_avx2;
+		kernels.min_max_row = min_max_row_avx2;
+		kernels.threshold_row = threshold_row_avx2;
+		kernels.max_channel_row = max_channel_row_avx2;
+		kernels.active_light_row = active_light_row_avx2;
+		kernels.motion_structure_row = motion_structure_row_avx2;
+		kernels.background_model_row = background_model_row_avx2;
+	}
+#endif
+
+#if SIMD_NEON
+	if (level == SIMD_LEVEL_NEON)
+	{
+		kernels.level = SIMD_LEVEL_NEON;
+		kernels.channel_diff_row = channel_diff_row_neon;
+		kernels.min_max_row = min_max_row_neon;
+		kernels.threshold_row = threshold_row_neon;
+		kernels.max_channel_row = max_channel_row_neon;
+		kernels.active_light_row = active_light_row_neon;
+		kernels.motion_structure_row = motion_structure_row_neon;
+		kernels.background_model_row = background_model_row_neon;
+	}
+#endif
+
+	return kernels;
+}
+
+string get_simd_level_name(const SIMDLevel level)
+{
+	switch (level)
+	{
+		case SIMD_LEVEL_SSE2: return "SSE2";
+		case SIMD_LEVEL_AVX2: return "AVX2";
+		case SIMD_LEVEL_NEON: return "NEON";
+		default:              return "scalar";
+	}
+}
+
+void channel_diff_row(const uchar* row_bgr, uchar* row_out, const int width)
+{
+	simd_kernels.channel_diff_row(row_bgr, row_out, width);
+}
+
+void min_max_row(const uchar* row, const int width, uchar& gray_min, uchar& gray_max)
+{
+	simd_kernels.min_max_row(row, width, gray_min, gray_max);
+}
+
+void lut_row(uchar* row, const int width, const uchar* lut)
+{
+	for (int i = 0; i < width; ++i)
+		row[i] = lut[row[i]];
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <string>
+#include <opencv2/opencv.hpp>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+using namespace cv;
+
+//per pixel background model layout: mean is gray in Q8.7, variance is gray^2 in Q12.4, count is consistent samples seen
+#define BACKGROUND_MODEL_VARIANCE_INIT 256
+#define BACKGROUND_MODEL_DEV_MAX       31
+#define BACKGROUND_MODEL_DIFF_MIN      6
+#define BACKGROUND_MODEL_COUNT_MAX     255
+
+enum SIMDLevel
+{
+	SIMD_LEVEL_SCALAR,
+	SIMD_LEVEL_SSE2,
+	SIMD_LEVEL_AVX2,
+	SIMD_LEVEL_NEON
+};
+
+//row kernels, they work on any row pointer so ROIs and non continuous Mats are fine
+struct SIMDKernels
+{
+	SIMDLevel level;
+
+	//min(B - G, R - G) with negative differences clamped to 0
+	void (*channel_diff_row)(const uchar* row_bgr, uchar* row_out, const int width);
+	//widens gray_min and gray_max to the range of the row
+	void (*min_max_row)(const uchar* row, const int width, uchar& gray_min, uchar& gray_max);
+	//gray where row_in > threshold_val and 0 elsewhere, i_min and i_max are the first and last hit or -1
+	void (*threshold_row)(const uchar* row_in, uchar* row_out, const int width, const uchar threshold_val, const uchar gray,
+						  int& i_min, int& i_max);
+	//max(B, G, R)
+	void (*max_channel_row)(const uchar* row_bgr, uchar* row_out, const int width);
+	//abs((B + G + R) / 3 - channel diff), 255 becomes 254
+	void (*active_light_row)(const uchar* row_bgr, const uchar* row_channel_diff, uchar* row_out, const int width);
+	//in - old + 127 clamped to 0..254
+	void (*motion_structure_row)(const uchar* row_in, const uchar* row_old, uchar* row_out, const int width);
+	//one update of the background model where row_skip is 0: pixels off by more than BACKGROUND_MODEL_DIFF_MIN and
+	//sqrt(6) sigma restart when they have fewer than lock_in samples and are left alone otherwise, the rest move toward
+	//the input at rate (Q16, below 0.5), locked_count and deviating_count are incremented for pixels at lock_in or above
+	void (*background_model_row)(const uchar* row_in, const uchar* row_skip, ushort* row_mean, ushort* row_variance, ushort* row_count,
+								 const int width, const short rate, const ushort lock_in, int& locked_count, int& deviating_count);
+};
+
+//picked once at startup from the CPU features, callers go through it
+extern SIMDKernels simd_kernels;
+
+SIMDKernels get_simd_kernels(const SIMDLevel level);
+SIMDLevel detect_simd_level();
+string get_simd_level_name(const SIMDLevel level);
+
+void channel_diff_row(const uchar* row_bgr, uchar* row_out, const int width);
+void min_max_row(const uchar* row, const int width, uchar& gray_min, uchar& gray_max);
+//256 byte table stays in L1, a scalar lookup is as fast as a gather here
+void lut_row(uchar* row, const int width, const uchar* lut);
\ No newline at end of file
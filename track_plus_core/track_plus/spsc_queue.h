@@ -0,0 +1,112 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <utility>
+
+using namespace std;
+
+//bounded single producer, single consumer queue between pipeline stages, unlike FrameMailbox nothing is dropped:
+//push blocks while the queue is full and pop blocks while it is empty, so items come out complete and in order
+template <typename T, int capacity>
+class SPSCQueue
+{
+public:
+	T items[capacity];
+
+	//push_count only moves on the producer thread, pop_count only on the consumer thread
+	atomic<unsigned> push_count;
+	atomic<unsigned> pop_count;
+
+	mutex wake_mutex;
+	condition_variable wake_condition;
+
+	SPSCQueue()
+	{
+		push_count = 0;
+		pop_count = 0;
+	}
+
+	void push(const T& item)
+	{
+		T item_copy = item;
+		push(move(item_copy));
+	}
+
+	//moves the item in, blobs and buffers of a frame change hands without being copied
+	void push(T&& item)
+	{
+		const unsigned index = push_count.load(memory_order_relaxed);
+		if (index - pop_count.load(memory_order_acquire) >= capacity)
+		{
+			unique_lock<mutex> lock(wake_mutex);
+			wake_condition.wait(lock, [this, index]
+			{
+				return index - pop_count.load(memory_order_acquire) < capacity;
+			});
+		}
+
+		items[index % capacity] = move(item);
+		push_count.store(index + 1, memory_order_release);
+		wake();
+	}
+
+	//returns false on timeout
+	bool pop(T& item, const int timeout_ms)
+	{
+		const unsigned index = pop_count.load(memory_order_relaxed);
+		if (push_count.load(memory_order_acquire) == index)
+		{
+			unique_lock<mutex> lock(wake_mutex);
+			const bool ready = wake_condition.wait_for(lock, chrono::milliseconds(timeout_ms), [this, index]
+			{
+				return push_count.load(memory_order_acquire) != index;
+			});
+
+			if (!ready)
+				return false;
+		}
+
+		//hand the slot back empty so the queue does not keep the images of old frames alive
+		item = move(items[index % capacity]);
+		items[index % capacity] = T();
+		pop_count.store(index + 1, memory_order_release);
+		wake();
+		return true;
+	}
+
+	bool empty()
+	{
+		return push_count.load(memory_order_acquire) == pop_count.load(memory_order_acquire);
+	}
+
+private:
+	//the other side checks the counters while holding the mutex, taking it here keeps the notification from getting lost
+	void wake()
+	{
+		{
+			lock_guard<mutex> lock(wake_mutex);
+		}
+		wake_condition.notify_all();
+	}
+};
\ No newline at end of file
@@ -101,6 +101,6 @@ bool StereoProcessorDTW::compute(SCOPA& scopa0, SCOPA& scopa1, PointResolver& po
 
 	//------------------------------------------------------------------------------------------------------------------------------
 
-	algo_name_vec.push_back(algo_name);
+	register_algo_name(algo_name);
 	return true;
 }
\ No newline at end of file
@@ -21,73 +21,132 @@
 
 using namespace cv;
 
-void ThinningComputer::thinning_iteration(Mat& image_in, const int iter, vector<Point>& points, int& iterations)
+static const int dx_neighbor[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+static const int dy_neighbor[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+ThinningComputer::ThinningComputer()
+{
+	for (int code = 0; code < 256; ++code)
+	{
+		const int p2 = (code >> 0) & 1;
+		const int p3 = (code >> 1) & 1;
+		const int p4 = (code >> 2) & 1;
+		const int p5 = (code >> 3) & 1;
+		const int p6 = (code >> 4) & 1;
+		const int p7 = (code >> 5) & 1;
+		const int p8 = (code >> 6) & 1;
+		const int p9 = (code >> 7) & 1;
+
+		const int A = (p2 == 0 && p3 > 0) + (p3 == 0 && p4 > 0) + (p4 == 0 && p5 > 0) + (p5 == 0 && p6 > 0) +
+					  (p6 == 0 && p7 > 0) + (p7 == 0 && p8 > 0) + (p8 == 0 && p9 > 0) + (p9 == 0 && p2 > 0);
+
+		const int B = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
+
+		for (int iter = 0; iter < 2; ++iter)
+		{
+			const int m1 = iter == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
+			const int m2 = iter == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
+
+			lut[iter][code] = A == 1 && (B >= 2 && B <= 6) && m1 == 0 && m2 == 0;
+		}
+	}
+}
+
+int ThinningComputer::thinning_iteration(Mat& image_in, const int iter)
 {
-    Mat marker = Mat::zeros(image_in.size(), CV_8UC1);
-
-    for (Point& pt : points)
-    {
-    	const uchar p2 = image_in.ptr<uchar>(pt.y - 1, pt.x)[0];
-        const uchar p3 = image_in.ptr<uchar>(pt.y - 1, pt.x + 1)[0];
-        const uchar p4 = image_in.ptr<uchar>(pt.y, pt.x + 1)[0];
-        const uchar p5 = image_in.ptr<uchar>(pt.y + 1, pt.x + 1)[0];
-        const uchar p6 = image_in.ptr<uchar>(pt.y + 1, pt.x)[0];
-        const uchar p7 = image_in.ptr<uchar>(pt.y + 1, pt.x - 1)[0];
-        const uchar p8 = image_in.ptr<uchar>(pt.y, pt.x - 1)[0];
-        const uchar p9 = image_in.ptr<uchar>(pt.y - 1, pt.x - 1)[0];
-
-        const int A  = (p2 == 0 && p3 > 0) + (p3 == 0 && p4 > 0) + (p4 == 0 && p5 > 0) + (p5 == 0 && p6 > 0) + 
-                       (p6 == 0 && p7 > 0) + (p7 == 0 && p8 > 0) + (p8 == 0 && p9 > 0) + (p9 == 0 && p2 > 0);
-
-        const int B  = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
-        const int m1 = iter == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
-        const int m2 = iter == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
-
-        if (A == 1 && (B >= 508 && B <= 1524) && m1 == 0 && m2 == 0)
-            marker.ptr<uchar>(pt.y, pt.x)[0] = 254;
-    }
-
-    image_in &= ~marker;
-    ++iterations;
+	const int width = image_in.cols;
+	const int step = image_in.step[0];
+
+	points_deleted.clear();
+	for (Point& pt : candidates[iter])
+	{
+		candidate_flags[iter][pt.y * width + pt.x] = 0;
+
+		const uchar* ptr = image_in.ptr<uchar>(pt.y) + pt.x;
+		if (ptr[0] == 0)
+			continue;
+
+		const int code = (ptr[-step] != 0)          | (ptr[1 - step] != 0) << 1 | (ptr[1] != 0) << 2  | (ptr[1 + step] != 0) << 3 |
+						 (ptr[step] != 0) << 4      | (ptr[step - 1] != 0) << 5 | (ptr[-1] != 0) << 6 | (ptr[-1 - step] != 0) << 7;
+
+		if (lut[iter][code])
+			points_deleted.push_back(pt);
+	}
+	candidates[iter].clear();
+
+	for (Point& pt : points_deleted)
+		image_in.ptr<uchar>(pt.y)[pt.x] = 0;
+
+	//the neighborhoods of the neighbors changed for both kinds of sub-iteration, so they go back into both lists
+	for (Point& pt : points_deleted)
+		for (int k = 0; k < 8; ++k)
+		{
+			const Point pt_neighbor = Point(pt.x + dx_neighbor[k], pt.y + dy_neighbor[k]);
+			const int index = pt_neighbor.y * width + pt_neighbor.x;
+			if (subject_flags[index] == 0 || image_in.ptr<uchar>(pt_neighbor.y)[pt_neighbor.x] == 0)
+				continue;
+
+			for (int i = 0; i < 2; ++i)
+				if (candidate_flags[i][index] == 0)
+				{
+					candidate_flags[i][index] = 1;
+					candidates[i].push_back(pt_neighbor);
+				}
+		}
+
+	return points_deleted.size();
 }
 
 vector<Point> ThinningComputer::compute_thinning(Mat& image_in, vector<Point>& points_in, const int max_iter)
 {
-    vector<Point> points;
-    for (Point& pt : points_in)
-    {
-        if (pt.x < 1 || pt.y < 1 || pt.x >= image_in.cols - 1 || pt.y >= image_in.rows - 1)
-            continue;
-
-        points.push_back(pt);
-    }
-
-    Mat prev = Mat::zeros(image_in.size(), CV_8UC1);
-    Mat diff = Mat::zeros(image_in.size(), CV_8UC1);
-    int iterations = 0;
-
-    do
-    {
-        thinning_iteration(image_in, 0, points, iterations);
-        thinning_iteration(image_in, 1, points, iterations);
-
-        for (Point& pt : points)
-        {
-            const uchar image_in_ptr = image_in.ptr<uchar>(pt.y, pt.x)[0];
-            diff.ptr<uchar>(pt.y, pt.x)[0] = abs(image_in_ptr - prev.ptr<uchar>(pt.y, pt.x)[0]);
-            prev.ptr<uchar>(pt.y, pt.x)[0] = image_in_ptr;
-        }
-
-        if (max_iter > -1 && iterations > max_iter)
-            break;
-    } 
-    while (countNonZero(diff) > 0);
-
-    vector<Point> result;
-
-    for (Point& pt : points)
-        if (image_in.ptr<uchar>(pt.y, pt.x)[0] > 0)
-            result.push_back(pt);
-
-    return result;
+	const int pixel_count = image_in.cols * image_in.rows;
+	subject_flags.assign(pixel_count, 0);
+
+	for (int i = 0; i < 2; ++i)
+	{
+		candidates[i].clear();
+		candidate_flags[i].assign(pixel_count, 0);
+	}
+
+	vector<Point> points;
+	for (Point& pt : points_in)
+	{
+		if (pt.x < 1 || pt.y < 1 || pt.x >= image_in.cols - 1 || pt.y >= image_in.rows - 1)
+			continue;
+
+		points.push_back(pt);
+
+		const int index = pt.y * image_in.cols + pt.x;
+		subject_flags[index] = 1;
+
+		for (int i = 0; i < 2; ++i)
+			if (candidate_flags[i][index] == 0)
+			{
+				candidate_flags[i][index] = 1;
+				candidates[i].push_back(pt);
+			}
+	}
+
+	//done once a pass deletes nothing, no image scan needed to tell
+	int iterations = 0;
+	while (true)
+	{
+		int count_deleted = thinning_iteration(image_in, 0);
+		count_deleted += thinning_iteration(image_in, 1);
+		iterations += 2;
+
+		if (count_deleted == 0)
+			break;
+
+		if (max_iter > -1 && iterations > max_iter)
+			break;
+	}
+
+	vector<Point> result;
+
+	for (Point& pt : points)
+		if (image_in.ptr<uchar>(pt.y, pt.x)[0] > 0)
+			result.push_back(pt);
+
+	return result;
 }
\ No newline at end of file
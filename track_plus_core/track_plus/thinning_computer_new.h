@@ -20,9 +20,24 @@
 
 #include <opencv2/opencv.hpp>
 
+//Zhang-Suen thinning, a 256 entry table per sub-iteration answers whether a pixel goes for each of its neighborhoods, and
+//after the first pass only the subject pixels next to ones deleted since their last look are looked at again
 class ThinningComputer
 {
 public:
-	void thinning_iteration(cv::Mat& image_in, const int iter, vector<cv::Point>& points, int& iterations);
+	ThinningComputer();
+
 	vector<cv::Point> compute_thinning(cv::Mat& image_in, vector<cv::Point>& points_in, const int max_iter = -1);
+
+private:
+	//neighbors clockwise from the top one are bits 0 to 7
+	uchar lut[2][256];
+
+	//pixels to look at in the next sub-iteration of each kind, flagged per pixel so that none goes in twice
+	vector<cv::Point> candidates[2];
+	vector<uchar> candidate_flags[2];
+	vector<uchar> subject_flags;
+	vector<cv::Point> points_deleted;
+
+	int thinning_iteration(cv::Mat& image_in, const int iter);
 };
\ No newline at end of file
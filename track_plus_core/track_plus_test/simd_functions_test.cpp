@@ -0,0 +1,190 @@
+/*
+ * Touch+ Software
+ * Copyright (C) 2015
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Aladdin Free Public License as
+ * published by the Aladdin Enterprises, either version 9 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Aladdin Free Public License for more details.
+ *
+ * You should have received a copy of the Aladdin Free Public License
+ * along with this program.  If not, see <http://ghostscript.com/doc/8.54/Public.htm>.
+ */
+
+//checks every SIMD row kernel the build and the CPU have against the scalar reference, the exit code is the number of
+//kernels that differ, see the Makefile for building it natively and for NEON
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "simd_functions.h"
+
+#define KERNEL_COUNT 7
+
+const char* kernel_names[KERNEL_COUNT] = { "channel_diff_row", "min_max_row", "threshold_row", "max_channel_row",
+										   "active_light_row", "motion_structure_row", "background_model_row" };
+
+//xorshift so that a failing check can be replayed, rand() differs between the platforms
+static inline unsigned int next_random(unsigned int& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+//random rows of all widths up to a few vectors plus tails and unaligned starts, failed[k] is set for every kernel k
+//that differs from scalar on any of them
+void check_kernels(const SIMDKernels& kernels, bool* failed)
+{
+	const SIMDKernels kernels_scalar = get_simd_kernels(SIMD_LEVEL_SCALAR);
+
+	//one past the widest vector loop of AVX2 (64 pixels) several times over, plus the small image width and odd sizes
+	const int width_max = 330;
+	const int widths[] = { 1, 2, 3, 7, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65, 95, 127, 128, 129, 191, 255, 320, 321, 329 };
+
+	unsigned int state = 0x9e3779b9;
+
+	vector<uchar> bgr(width_max * 3 + 1);
+	vector<uchar> in(width_max + 1);
+	vector<uchar> old(width_max + 1);
+	vector<uchar> skip(width_max + 1);
+	vector<uchar> out0(width_max + 1);
+	vector<uchar> out1(width_max + 1);
+	vector<ushort> mean0(width_max);
+	vector<ushort> mean1(width_max);
+	vector<ushort> variance0(width_max);
+	vector<ushort> variance1(width_max);
+	vector<ushort> count0(width_max);
+	vector<ushort> count1(width_max);
+
+	for (int k = 0; k < KERNEL_COUNT; ++k)
+		failed[k] = false;
+
+	for (const int width : widths)
+		for (int pass = 0; pass < 8; ++pass)
+		{
+			//odd passes start one byte in so that the loads are unaligned
+			const int offset = pass % 2;
+
+			//even passes keep values near the ends and near each other, where the saturating paths are taken
+			const unsigned int range = pass < 4 ? 256 : 8;
+			for (uchar& val : bgr)
+				val = range == 256 ? next_random(state) & 255 : 124 + next_random(state) % range;
+			for (int i = 0; i <= width_max; ++i)
+			{
+				in[i] = next_random(state) & 255;
+				old[i] = range == 256 ? next_random(state) & 255 : in[i] + (int)(next_random(state) % 16) - 8;
+				skip[i] = (next_random(state) & 7) == 0 ? 254 : 0;
+			}
+
+			const uchar* row_bgr = &bgr[offset];
+			const uchar* row_in = &in[offset];
+			const uchar* row_old = &old[offset];
+
+			kernels_scalar.channel_diff_row(row_bgr, &out0[0], width);
+			kernels.channel_diff_row(row_bgr, &out1[0], width);
+			if (memcmp(&out0[0], &out1[0], width) != 0)
+				failed[0] = true;
+
+			uchar gray_min0 = 255 - (next_random(state) & 63);
+			uchar gray_max0 = next_random(state) & 63;
+			uchar gray_min1 = gray_min0;
+			uchar gray_max1 = gray_max0;
+			kernels_scalar.min_max_row(row_in, width, gray_min0, gray_max0);
+			kernels.min_max_row(row_in, width, gray_min1, gray_max1);
+			if (gray_min0 != gray_min1 || gray_max0 != gray_max1)
+				failed[1] = true;
+
+			const uchar threshold_val = next_random(state) & 255;
+			int i_min0;
+			int i_max0;
+			int i_min1;
+			int i_max1;
+			kernels_scalar.threshold_row(row_in, &out0[0], width, threshold_val, 254, i_min0, i_max0);
+			kernels.threshold_row(row_in, &out1[0], width, threshold_val, 254, i_min1, i_max1);
+			if (memcmp(&out0[0], &out1[0], width) != 0 || i_min0 != i_min1 || i_max0 != i_max1)
+				failed[2] = true;
+
+			kernels_scalar.max_channel_row(row_bgr, &out0[0], width);
+			kernels.max_channel_row(row_bgr, &out1[0], width);
+			if (memcmp(&out0[0], &out1[0], width) != 0)
+				failed[3] = true;
+
+			kernels_scalar.active_light_row(row_bgr, row_old, &out0[0], width);
+			kernels.active_light_row(row_bgr, row_old, &out1[0], width);
+			if (memcmp(&out0[0], &out1[0], width) != 0)
+				failed[4] = true;
+
+			kernels_scalar.motion_structure_row(row_in, row_old, &out0[0], width);
+			kernels.motion_structure_row(row_in, row_old, &out1[0], width);
+			if (memcmp(&out0[0], &out1[0], width) != 0)
+				failed[5] = true;
+
+			//a model state from every branch: new pixels, locked and unlocked ones, near and far from the input
+			for (int i = 0; i < width; ++i)
+			{
+				const int gray = range == 256 ? next_random(state) & 255 : row_in[i] + (int)(next_random(state) % 16) - 8;
+				mean0[i] = (ushort)(min(max(gray, 0), 255) << 7) + (next_random(state) & 127);
+				variance0[i] = next_random(state) % (BACKGROUND_MODEL_DEV_MAX * BACKGROUND_MODEL_DEV_MAX * 16 + 1);
+				count0[i] = next_random(state) % (BACKGROUND_MODEL_COUNT_MAX + 1);
+				if ((next_random(state) & 7) == 0)
+					count0[i] = 0;
+			}
+			mean1 = mean0;
+			variance1 = variance0;
+			count1 = count0;
+
+			const short rate = 2048 + next_random(state) % (32767 - 2048 + 1);
+			int locked_count0 = 0;
+			int deviating_count0 = 0;
+			int locked_count1 = 0;
+			int deviating_count1 = 0;
+			kernels_scalar.background_model_row(row_in, &skip[offset], &mean0[0], &variance0[0], &count0[0], width, rate, 8,
+												locked_count0, deviating_count0);
+			kernels.background_model_row(row_in, &skip[offset], &mean1[0], &variance1[0], &count1[0], width, rate, 8,
+										 locked_count1, deviating_count1);
+			if (mean0 != mean1 || variance0 != variance1 || count0 != count1 ||
+				locked_count0 != locked_count1 || deviating_count0 != deviating_count1)
+				failed[6] = true;
+		}
+}
+
+int main()
+{
+	const SIMDLevel level_detected = detect_simd_level();
+	printf("detected %s\n", get_simd_level_name(level_detected).c_str());
+
+	//every level up to the detected one, AVX2 machines run the SSE2 kernels as well
+	vector<SIMDLevel> levels;
+	if (level_detected == SIMD_LEVEL_NEON)
+		levels.push_back(SIMD_LEVEL_NEON);
+	if (level_detected == SIMD_LEVEL_SSE2 || level_detected == SIMD_LEVEL_AVX2)
+		levels.push_back(SIMD_LEVEL_SSE2);
+	if (level_detected == SIMD_LEVEL_AVX2)
+		levels.push_back(SIMD_LEVEL_AVX2);
+
+	int fail_count = 0;
+	for (const SIMDLevel level : levels)
+	{
+		bool failed[KERNEL_COUNT];
+		check_kernels(get_simd_kernels(level), failed);
+
+		for (int k = 0; k < KERNEL_COUNT; ++k)
+		{
+			printf("%-6s %-22s %s\n", get_simd_level_name(level).c_str(), kernel_names[k], failed[k] ? "FAIL" : "ok");
+			if (failed[k])
+				++fail_count;
+		}
+	}
+
+	if (levels.empty())
+		printf("no SIMD kernels in this build\n");
+
+	return fail_count;
+}
\ No newline at end of file